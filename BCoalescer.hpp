@@ -0,0 +1,190 @@
+/* 
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __BCOALESCER_HPP
+#define __BCOALESCER_HPP
+
+#include "BRingBuffer.hpp"
+#include <cstring>
+
+namespace brb
+{
+    template<std::uint32_t maxDataSize>
+    using RecordLength = std::conditional_t<maxDataSize <= 0xFFFF, std::uint16_t, std::uint32_t>;
+}
+
+template<typename Buffer, std::uint32_t maxRecords = Buffer::MAX_DATA_SIZE>
+class BCoalescer
+{
+private:
+    using Length = brb::RecordLength<Buffer::MAX_DATA_SIZE>;
+    static_assert(Buffer::MAX_DATA_SIZE > sizeof(Length), "bucket too small for a length-prefixed record");
+
+    Buffer& buffer;
+    char* bucket = nullptr;
+    std::uint32_t used = 0;
+    std::uint32_t count = 0;
+
+public:
+    static constexpr std::uint32_t MAX_RECORD_SIZE = Buffer::MAX_DATA_SIZE - sizeof(Length);
+
+    explicit BCoalescer(Buffer& buffer)
+        : buffer(buffer)
+    {
+    }
+
+    ~BCoalescer()
+    {
+        flush();
+    }
+
+    BCoalescer(const BCoalescer&) = delete;
+    BCoalescer& operator=(const BCoalescer&) = delete;
+
+    void* append(const std::uint32_t dataSize)
+    {
+        if (dataSize > MAX_RECORD_SIZE)
+        {
+            return nullptr;
+        }
+
+        if (bucket && (count == maxRecords || used + sizeof(Length) + dataSize > Buffer::MAX_DATA_SIZE))
+        {
+            flush();
+        }
+
+        if (nullptr == bucket)
+        {
+            bucket = static_cast<char*>(buffer.reserve(Buffer::MAX_DATA_SIZE));
+            if (nullptr == bucket)
+            {
+                return nullptr;
+            }
+        }
+
+        const Length length = dataSize;
+        memcpy(bucket + used, &length, sizeof(Length));
+        void* const dataPtr = bucket + used + sizeof(Length);
+        used += sizeof(Length) + dataSize;
+        ++count;
+        return dataPtr;
+    }
+
+    bool append(const void* const data, const std::uint32_t dataSize)
+    {
+        void* const dataPtr = append(dataSize);
+        if (nullptr == dataPtr)
+        {
+            return false;
+        }
+        memcpy(dataPtr, data, dataSize);
+        if (count == maxRecords)
+        {
+            flush();
+        }
+        return true;
+    }
+
+    void flush()
+    {
+        if (bucket)
+        {
+            buffer.commit(bucket, used);
+            bucket = nullptr;
+            used = 0;
+            count = 0;
+        }
+    }
+};
+
+template<typename Buffer>
+class BCoalescedRecords
+{
+private:
+    using Length = brb::RecordLength<Buffer::MAX_DATA_SIZE>;
+
+    const char* const first;
+    const char* const last;
+
+public:
+    struct Record
+    {
+        const void* data;
+        std::uint32_t size;
+    };
+
+    class Iterator
+    {
+    private:
+        const char* position;
+
+    public:
+        explicit Iterator(const char* const position)
+            : position(position)
+        {
+        }
+
+        Record operator*() const
+        {
+            Length length;
+            memcpy(&length, position, sizeof(Length));
+            return { position + sizeof(Length), length };
+        }
+
+        Iterator& operator++()
+        {
+            Length length;
+            memcpy(&length, position, sizeof(Length));
+            position += sizeof(Length) + length;
+            return *this;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return position != other.position;
+        }
+    };
+
+    BCoalescedRecords(const void* const dataPtr, const std::uint32_t dataSize)
+        : first(static_cast<const char*>(dataPtr)), last(static_cast<const char*>(dataPtr) + dataSize)
+    {
+    }
+
+    Iterator begin() const
+    {
+        return Iterator(first);
+    }
+
+    Iterator end() const
+    {
+        return Iterator(last);
+    }
+};
+
+#endif
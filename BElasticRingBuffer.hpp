@@ -0,0 +1,238 @@
+/* 
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __BELASTICRINGBUFFER_HPP
+#define __BELASTICRINGBUFFER_HPP
+
+#include "BRingBuffer.hpp"
+#include <memory>
+
+#include <linux/membarrier.h>
+
+template<std::uint32_t maxSegments, std::uint32_t capacity, std::uint32_t maxDataSize, typename Traits = BRingBufferTraits>
+class BElasticRingBuffer
+{
+private:
+    static_assert(!Traits::overwrite, "overwrite buffers do not fill up");
+
+    using Buffer = BRingBuffer<capacity, maxDataSize, Traits>;
+
+    // committed by a producer which reserved in a segment already left by the consumer
+    static constexpr std::uint32_t TOMBSTONE = ~0u;
+
+    struct Segment
+    {
+        Buffer buffer;
+        alignas (std::hardware_destructive_interference_size) std::atomic<Segment*> next{ nullptr };
+        alignas (std::hardware_destructive_interference_size) std::uint64_t magicId = 0;
+
+        bool contains(const void* const dataPtr) const
+        {
+            return static_cast<const char*>(dataPtr) >= reinterpret_cast<const char*>(this) && static_cast<const char*>(dataPtr) < reinterpret_cast<const char*>(this + 1);
+        }
+    };
+
+    alignas (std::hardware_destructive_interference_size) std::atomic<Segment*> tail{ nullptr };
+    alignas (std::hardware_destructive_interference_size) Segment* head = nullptr;
+    alignas (std::hardware_destructive_interference_size) std::atomic<bool> locked{ false };
+    std::uint32_t allocatedCount = 0;
+    std::uint32_t poolSize = 0;
+    Segment* pool[maxSegments] = { nullptr };
+    std::unique_ptr<Segment> segments[maxSegments];
+
+    void lock()
+    {
+        while (locked.exchange(true, std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock()
+    {
+        locked.store(false, std::memory_order_release);
+    }
+
+    bool grow(Segment* const full)
+    {
+        lock();
+        bool grown = true;
+        if (tail.load(std::memory_order_relaxed) == full)
+        {
+            Segment* segment = nullptr;
+            if (poolSize)
+            {
+                segment = pool[--poolSize];
+            }
+            else if (allocatedCount < maxSegments)
+            {
+                segments[allocatedCount] = std::make_unique<Segment>();
+                segment = segments[allocatedCount++].get();
+            }
+
+            if (segment)
+            {
+                segment->next.store(nullptr, std::memory_order_relaxed);
+                full->next.store(segment, std::memory_order_release);
+                tail.store(segment, std::memory_order_release);
+            }
+            grown = nullptr != segment;
+        }
+        unlock();
+        return grown;
+    }
+
+    void retire(Segment* const segment)
+    {
+        lock();
+        pool[poolSize++] = segment;
+        unlock();
+    }
+
+    Segment* segmentOf(const void* const dataPtr)
+    {
+        Segment* const segment = tail.load(std::memory_order_acquire);
+        if (segment->contains(dataPtr))
+        {
+            return segment;
+        }
+
+        for (std::uint32_t i = 0; ; ++i)
+        {
+            if (segments[i]->contains(dataPtr))
+            {
+                return segments[i].get();
+            }
+        }
+    }
+
+    static void serializeProducers()
+    {
+        syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+    }
+
+public:
+    BElasticRingBuffer()
+    {
+        static_assert(0 != maxSegments, "at least one segment is required");
+        if (0 != syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0))
+        {
+            throw std::system_error(errno, std::generic_category(), "membarrier() failed");
+        }
+
+        segments[0] = std::make_unique<Segment>();
+        allocatedCount = 1;
+        head = segments[0].get();
+        tail.store(head, std::memory_order_relaxed);
+    }
+
+    BElasticRingBuffer(const BElasticRingBuffer&) = delete;
+    BElasticRingBuffer& operator=(const BElasticRingBuffer&) = delete;
+
+    void* reserve(const std::uint32_t dataSize)
+    {
+        while (true)
+        {
+            Segment* const segment = tail.load(std::memory_order_acquire);
+            void* const dataPtr = segment->buffer.reserve(dataSize);
+            if (nullptr == dataPtr)
+            {
+                if (!grow(segment))
+                {
+                    return nullptr;
+                }
+                continue;
+            }
+
+            // pairs with serializeProducers() of the consumer leaving the segment
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            if (nullptr == segment->next.load(std::memory_order_relaxed))
+            {
+                return dataPtr;
+            }
+            segment->buffer.commit(dataPtr, TOMBSTONE);
+        }
+    }
+
+    void commit(void* const dataPtr)
+    {
+        segmentOf(dataPtr)->buffer.commit(dataPtr);
+    }
+
+    void commit(void* const dataPtr, const std::uint32_t dataSize)
+    {
+        segmentOf(dataPtr)->buffer.commit(dataPtr, dataSize);
+    }
+
+    void* peek(std::uint32_t& dataSize)
+    {
+        while (true)
+        {
+            if (void* const dataPtr = head->buffer.peek(dataSize, head->magicId))
+            {
+                if (TOMBSTONE != dataSize)
+                {
+                    return dataPtr;
+                }
+                head->buffer.decommit(dataPtr, head->magicId);
+                continue;
+            }
+
+            Segment* const next = head->next.load(std::memory_order_acquire);
+            if (nullptr == next || !head->buffer.drained(head->magicId))
+            {
+                return nullptr;
+            }
+
+            // a producer reserving after this point sees the next segment and leaves a tombstone
+            serializeProducers();
+            if (!head->buffer.drained(head->magicId))
+            {
+                return nullptr;
+            }
+
+            retire(head);
+            head = next;
+        }
+    }
+
+    void decommit(void* const dataPtr)
+    {
+        head->buffer.decommit(dataPtr, head->magicId);
+    }
+
+    std::uint32_t allocatedSegments()
+    {
+        lock();
+        const std::uint32_t count = allocatedCount;
+        unlock();
+        return count;
+    }
+};
+
+#endif
@@ -0,0 +1,189 @@
+/* 
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __BPRIORITYRINGBUFFER_HPP
+#define __BPRIORITYRINGBUFFER_HPP
+
+#include "BRingBuffer.hpp"
+
+template<std::uint32_t laneCount, std::uint32_t capacity, std::uint32_t maxDataSize, typename Traits = BRingBufferTraits>
+class BPriorityRingBuffer
+{
+private:
+    using Lane = BRingBuffer<capacity, maxDataSize, Traits>;
+
+    const std::uint32_t starvationBound;
+    alignas (std::hardware_destructive_interference_size) std::uint32_t currentLane = 0;
+    std::uint32_t streak = 0;
+    std::uint32_t starvedLane = 1;
+    std::uint64_t magicIds[laneCount] = { 0 };
+    Lane lanes[laneCount];
+
+    std::uint32_t laneOf(const void* const dataPtr) const
+    {
+        return (static_cast<const char*>(dataPtr) - reinterpret_cast<const char*>(lanes)) / sizeof(Lane);
+    }
+
+    // returns laneCount if the lower lanes are not starved
+    std::uint32_t starvedTurn()
+    {
+        if (0 == starvationBound || streak < starvationBound || 1 == laneCount)
+        {
+            return laneCount;
+        }
+
+        // every lower lane in turn gets the first look after starvationBound messages
+        const std::uint32_t laneId = starvedLane;
+        starvedLane = starvedLane + 1 < laneCount ? starvedLane + 1 : 1;
+        streak = 0;
+        return laneId;
+    }
+
+public:
+    explicit BPriorityRingBuffer(const std::uint32_t starvationBound = 0)
+        : starvationBound(starvationBound)
+    {
+        static_assert(0 != laneCount, "at least one lane is required");
+    }
+
+    void* reserve(const std::uint32_t priority, const std::uint32_t dataSize)
+    {
+        return lanes[priority].reserve(dataSize);
+    }
+
+    void commit(void* const dataPtr)
+    {
+        lanes[laneOf(dataPtr)].commit(dataPtr);
+    }
+
+    void commit(void* const dataPtr, const std::uint32_t dataSize)
+    {
+        lanes[laneOf(dataPtr)].commit(dataPtr, dataSize);
+    }
+
+    std::uint32_t reserveBatch(const std::uint32_t priority, void** const dataPtrs, const std::uint32_t count, const std::uint32_t dataSize)
+    {
+        return lanes[priority].reserveBatch(dataPtrs, count, dataSize);
+    }
+
+    void commitBatch(void* const* const dataPtrs, const std::uint32_t count)
+    {
+        if (count)
+        {
+            lanes[laneOf(dataPtrs[0])].commitBatch(dataPtrs, count);
+        }
+    }
+
+    void* peek(std::uint32_t& dataSize)
+    {
+        // only the starved lane goes first, if it is empty the others are checked in the priority order
+        const std::uint32_t starved = starvedTurn();
+        if (laneCount != starved)
+        {
+            if (void* dataPtr = lanes[starved].peek(dataSize, magicIds[starved]))
+            {
+                currentLane = starved;
+                return dataPtr;
+            }
+        }
+        for (std::uint32_t laneId = 0; laneId < laneCount; ++laneId)
+        {
+            if (laneId == starved)
+            {
+                continue;
+            }
+            if (void* dataPtr = lanes[laneId].peek(dataSize, magicIds[laneId]))
+            {
+                currentLane = laneId;
+                return dataPtr;
+            }
+        }
+        return nullptr;
+    }
+
+    void decommit(void* const dataPtr)
+    {
+        const std::uint32_t laneId = laneOf(dataPtr);
+        lanes[laneId].decommit(dataPtr, magicIds[laneId]);
+        ++streak;
+    }
+
+    std::uint32_t peekBatch(void** const dataPtrs, std::uint32_t* const dataSizes, const std::uint32_t maxCount)
+    {
+        const std::uint32_t starved = starvedTurn();
+        if (laneCount != starved)
+        {
+            if (std::uint32_t peeked = lanes[starved].peekBatch(dataPtrs, dataSizes, maxCount, magicIds[starved]))
+            {
+                currentLane = starved;
+                return peeked;
+            }
+        }
+        for (std::uint32_t laneId = 0; laneId < laneCount; ++laneId)
+        {
+            if (laneId == starved)
+            {
+                continue;
+            }
+            if (std::uint32_t peeked = lanes[laneId].peekBatch(dataPtrs, dataSizes, maxCount, magicIds[laneId]))
+            {
+                currentLane = laneId;
+                return peeked;
+            }
+        }
+        return 0;
+    }
+
+    void decommitBatch(const std::uint32_t count)
+    {
+        if (0 == count)
+        {
+            return;
+        }
+
+        lanes[currentLane].decommitBatch(count, magicIds[currentLane]);
+        streak += count;
+    }
+
+    std::uint32_t priorityOf(const void* const dataPtr) const
+    {
+        return laneOf(dataPtr);
+    }
+
+    brb::Statistics statistics() const
+    {
+        brb::Statistics statistics;
+        for (const Lane& lane : lanes)
+        {
+            statistics += lane.statistics();
+        }
+        return statistics;
+    }
+};
+
+#endif
@@ -32,104 +32,2051 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <atomic>
+#include <chrono>
+#include <algorithm>
 #include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 
-template<std::uint32_t capacity, std::uint32_t maxDataSize>
+#include <cpuid.h>
+#include <immintrin.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+namespace brb
+{
+    enum class Layout
+    {
+        Padded,
+        Packed,
+        Split
+    };
+
+    enum class Engine
+    {
+        Cas,
+        Sequence
+    };
+
+    constexpr std::uint32_t DYNAMIC = 0;
+
+    struct MemoryOptions
+    {
+        bool hugePages = false;
+        int numaNode = -1;
+    };
+
+    class Memory
+    {
+    private:
+        static constexpr std::size_t HUGE_PAGE_SIZE = 1 << 21;
+        static constexpr int MAX_NUMA_NODES = 1024;
+
+        void* address = nullptr;
+        std::size_t length = 0;
+
+        static void* map(const std::size_t size, const int flags)
+        {
+            void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+            return MAP_FAILED == ptr ? nullptr : ptr;
+        }
+
+    public:
+        Memory(const std::size_t size, const MemoryOptions& options)
+        {
+            if (options.hugePages)
+            {
+                length = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+                address = map(length, MAP_HUGETLB);
+                if (nullptr == address)
+                {
+                    // no reserved huge pages, use transparent huge pages on a 2MB aligned region
+                    char* ptr = static_cast<char*>(map(length + HUGE_PAGE_SIZE, 0));
+                    if (nullptr != ptr)
+                    {
+                        char* aligned = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(ptr) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+                        if (aligned != ptr)
+                        {
+                            munmap(ptr, aligned - ptr);
+                        }
+                        munmap(aligned + length, ptr + HUGE_PAGE_SIZE - aligned);
+                        madvise(aligned, length, MADV_HUGEPAGE);
+                        address = aligned;
+                    }
+                }
+            }
+            else
+            {
+                const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+                length = (size + pageSize - 1) & ~(pageSize - 1);
+                address = map(length, 0);
+            }
+
+            if (nullptr == address)
+            {
+                throw std::system_error(errno, std::generic_category(), "mmap() failed");
+            }
+
+            if (options.numaNode >= 0)
+            {
+                constexpr std::size_t BITS = 8 * sizeof(unsigned long);
+                unsigned long nodeMask[MAX_NUMA_NODES / BITS] = { 0 };
+                if (options.numaNode < MAX_NUMA_NODES)
+                {
+                    nodeMask[options.numaNode / BITS] = 1UL << (options.numaNode % BITS);
+                }
+                if (0 != syscall(SYS_mbind, address, length, MPOL_BIND, nodeMask, MAX_NUMA_NODES + 1, 0))
+                {
+                    const int error = errno;
+                    munmap(address, length);
+                    throw std::system_error(error, std::generic_category(), "mbind() failed");
+                }
+            }
+        }
+
+        ~Memory()
+        {
+            munmap(address, length);
+        }
+
+        Memory(const Memory&) = delete;
+        Memory& operator=(const Memory&) = delete;
+
+        void* get() const
+        {
+            return address;
+        }
+    };
+
+    // distinct tags, empty members of the same type may not share an address
+    template<int tag>
+    struct Empty
+    {
+    };
+
+    template<Layout layout, typename Flag>
+    constexpr std::size_t bucketAlignment = std::max<std::size_t>(Layout::Padded == layout ? std::hardware_destructive_interference_size : alignof(Flag), alignof(std::uint32_t));
+
+    template<Layout layout, typename Flag, std::uint32_t maxDataSize, typename Stamp>
+    struct alignas(bucketAlignment<layout, Flag>) Bucket
+    {
+        Flag flag{ 0 };
+        std::uint32_t size = 0;
+        [[no_unique_address]] Stamp timestamp{};
+        alignas (Flag) char payload[maxDataSize] = { 0 };
+    };
+
+    template<typename Flag, typename Stamp>
+    struct Header
+    {
+        Flag flag{ 0 };
+        std::uint32_t size = 0;
+        [[no_unique_address]] Stamp timestamp{};
+    };
+
+    constexpr std::uint32_t roundUpToPowerOfTwo(const std::uint32_t value)
+    {
+        std::uint32_t result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    inline std::uint32_t dynamicCapacity(const std::uint32_t bucketCount)
+    {
+        if (bucketCount > (1u << 31))
+        {
+            throw std::length_error("capacity exceeds 2^31 buckets");
+        }
+        return roundUpToPowerOfTwo(bucketCount);
+    }
+
+    template<Layout layout, typename Flag, std::uint32_t capacity, std::uint32_t maxDataSize, typename Stamp>
+    class Storage
+    {
+    private:
+        using Bucket = brb::Bucket<layout, Flag, maxDataSize, Stamp>;
+
+        static_assert(Layout::Padded != layout || alignof(Bucket) == std::hardware_destructive_interference_size, "padded bucket must be aligned to a cache line");
+        static_assert(Layout::Padded != layout || 0 == sizeof(Bucket) % std::hardware_destructive_interference_size, "padded bucket must fill whole cache lines");
+
+        alignas (std::hardware_destructive_interference_size) Bucket data[capacity];
+
+    public:
+        static constexpr std::uint32_t OFFSET_TO_PAYLOAD = offsetof(Bucket, payload);
+        static constexpr std::uint32_t STRIDE = sizeof(Bucket);
+
+        static constexpr std::uint32_t bucketCount()
+        {
+            return capacity;
+        }
+
+        static constexpr std::uint32_t bucketIndex(const std::uint64_t position)
+        {
+            return position % capacity;
+        }
+
+        Flag& flag(const std::uint32_t id)
+        {
+            return data[id].flag;
+        }
+
+        Flag& flag(void* const dataPtr)
+        {
+            return reinterpret_cast<Bucket*>(static_cast<char*>(dataPtr) - OFFSET_TO_PAYLOAD)->flag;
+        }
+
+        std::uint32_t& size(const std::uint32_t id)
+        {
+            return data[id].size;
+        }
+
+        std::uint32_t& size(void* const dataPtr)
+        {
+            return reinterpret_cast<Bucket*>(static_cast<char*>(dataPtr) - OFFSET_TO_PAYLOAD)->size;
+        }
+
+        Stamp& timestamp(const std::uint32_t id)
+        {
+            return data[id].timestamp;
+        }
+
+        Stamp& timestamp(void* const dataPtr)
+        {
+            return reinterpret_cast<Bucket*>(static_cast<char*>(dataPtr) - OFFSET_TO_PAYLOAD)->timestamp;
+        }
+
+        char* payload(const std::uint32_t id)
+        {
+            return data[id].payload;
+        }
+
+        void* begin()
+        {
+            return data;
+        }
+    };
+
+    template<typename Flag, std::uint32_t capacity, std::uint32_t maxDataSize, typename Stamp>
+    class Storage<Layout::Split, Flag, capacity, maxDataSize, Stamp>
+    {
+    private:
+        using Header = brb::Header<Flag, Stamp>;
+
+        alignas (std::hardware_destructive_interference_size) Header headers[capacity];
+        alignas (std::hardware_destructive_interference_size) char payloads[capacity][maxDataSize] = { { 0 } };
+
+    public:
+        static constexpr std::uint32_t OFFSET_TO_PAYLOAD = 0;
+        static constexpr std::uint32_t STRIDE = maxDataSize;
+
+        static constexpr std::uint32_t bucketCount()
+        {
+            return capacity;
+        }
+
+        static constexpr std::uint32_t bucketIndex(const std::uint64_t position)
+        {
+            return position % capacity;
+        }
+
+        Flag& flag(const std::uint32_t id)
+        {
+            return headers[id].flag;
+        }
+
+        Flag& flag(void* const dataPtr)
+        {
+            return headers[(static_cast<char*>(dataPtr) - payloads[0]) / maxDataSize].flag;
+        }
+
+        std::uint32_t& size(const std::uint32_t id)
+        {
+            return headers[id].size;
+        }
+
+        std::uint32_t& size(void* const dataPtr)
+        {
+            return headers[(static_cast<char*>(dataPtr) - payloads[0]) / maxDataSize].size;
+        }
+
+        Stamp& timestamp(const std::uint32_t id)
+        {
+            return headers[id].timestamp;
+        }
+
+        Stamp& timestamp(void* const dataPtr)
+        {
+            return headers[(static_cast<char*>(dataPtr) - payloads[0]) / maxDataSize].timestamp;
+        }
+
+        char* payload(const std::uint32_t id)
+        {
+            return payloads[id];
+        }
+
+        void* begin()
+        {
+            return payloads;
+        }
+    };
+
+    template<Layout layout, typename Flag, std::uint32_t maxDataSize, typename Stamp>
+    class Storage<layout, Flag, DYNAMIC, maxDataSize, Stamp>
+    {
+    private:
+        using Bucket = brb::Bucket<layout, Flag, maxDataSize, Stamp>;
+
+        static_assert(Layout::Padded != layout || alignof(Bucket) == std::hardware_destructive_interference_size, "padded bucket must be aligned to a cache line");
+        static_assert(Layout::Padded != layout || 0 == sizeof(Bucket) % std::hardware_destructive_interference_size, "padded bucket must fill whole cache lines");
+
+        const std::uint32_t capacity;
+        Memory memory;
+        Bucket* const data;
+
+    public:
+        static constexpr std::uint32_t OFFSET_TO_PAYLOAD = offsetof(Bucket, payload);
+        static constexpr std::uint32_t STRIDE = sizeof(Bucket);
+
+        Storage(const std::uint32_t bucketCount, const MemoryOptions& options)
+            : capacity(dynamicCapacity(bucketCount)), memory(capacity * sizeof(Bucket), options), data(static_cast<Bucket*>(memory.get()))
+        {
+            for (std::uint32_t i = 0; i < capacity; ++i)
+            {
+                new (&data[i]) Bucket();
+            }
+        }
+
+        std::uint32_t bucketCount() const
+        {
+            return capacity;
+        }
+
+        std::uint32_t bucketIndex(const std::uint64_t position) const
+        {
+            return position & (capacity - 1);
+        }
+
+        Flag& flag(const std::uint32_t id)
+        {
+            return data[id].flag;
+        }
+
+        Flag& flag(void* const dataPtr)
+        {
+            return reinterpret_cast<Bucket*>(static_cast<char*>(dataPtr) - OFFSET_TO_PAYLOAD)->flag;
+        }
+
+        std::uint32_t& size(const std::uint32_t id)
+        {
+            return data[id].size;
+        }
+
+        std::uint32_t& size(void* const dataPtr)
+        {
+            return reinterpret_cast<Bucket*>(static_cast<char*>(dataPtr) - OFFSET_TO_PAYLOAD)->size;
+        }
+
+        Stamp& timestamp(const std::uint32_t id)
+        {
+            return data[id].timestamp;
+        }
+
+        Stamp& timestamp(void* const dataPtr)
+        {
+            return reinterpret_cast<Bucket*>(static_cast<char*>(dataPtr) - OFFSET_TO_PAYLOAD)->timestamp;
+        }
+
+        char* payload(const std::uint32_t id)
+        {
+            return data[id].payload;
+        }
+
+        void* begin()
+        {
+            return data;
+        }
+    };
+
+    template<typename Flag, std::uint32_t maxDataSize, typename Stamp>
+    class Storage<Layout::Split, Flag, DYNAMIC, maxDataSize, Stamp>
+    {
+    private:
+        using Header = brb::Header<Flag, Stamp>;
+
+        static std::size_t payloadsOffset(const std::uint32_t capacity)
+        {
+            return (static_cast<std::size_t>(capacity) * sizeof(Header) + std::hardware_destructive_interference_size - 1) & ~(std::hardware_destructive_interference_size - 1);
+        }
+
+        const std::uint32_t capacity;
+        Memory memory;
+        Header* const headers;
+        char* const payloads;
+
+    public:
+        static constexpr std::uint32_t OFFSET_TO_PAYLOAD = 0;
+        static constexpr std::uint32_t STRIDE = maxDataSize;
+
+        Storage(const std::uint32_t bucketCount, const MemoryOptions& options)
+            : capacity(dynamicCapacity(bucketCount)), memory(payloadsOffset(capacity) + static_cast<std::size_t>(capacity) * maxDataSize, options),
+              headers(static_cast<Header*>(memory.get())), payloads(static_cast<char*>(memory.get()) + payloadsOffset(capacity))
+        {
+            for (std::uint32_t i = 0; i < capacity; ++i)
+            {
+                new (&headers[i]) Header();
+            }
+            std::fill(payloads, payloads + static_cast<std::size_t>(capacity) * maxDataSize, 0);
+        }
+
+        std::uint32_t bucketCount() const
+        {
+            return capacity;
+        }
+
+        std::uint32_t bucketIndex(const std::uint64_t position) const
+        {
+            return position & (capacity - 1);
+        }
+
+        Flag& flag(const std::uint32_t id)
+        {
+            return headers[id].flag;
+        }
+
+        Flag& flag(void* const dataPtr)
+        {
+            return headers[(static_cast<char*>(dataPtr) - payloads) / maxDataSize].flag;
+        }
+
+        std::uint32_t& size(const std::uint32_t id)
+        {
+            return headers[id].size;
+        }
+
+        std::uint32_t& size(void* const dataPtr)
+        {
+            return headers[(static_cast<char*>(dataPtr) - payloads) / maxDataSize].size;
+        }
+
+        Stamp& timestamp(const std::uint32_t id)
+        {
+            return headers[id].timestamp;
+        }
+
+        Stamp& timestamp(void* const dataPtr)
+        {
+            return headers[(static_cast<char*>(dataPtr) - payloads) / maxDataSize].timestamp;
+        }
+
+        char* payload(const std::uint32_t id)
+        {
+            return payloads + static_cast<std::size_t>(id) * maxDataSize;
+        }
+
+        void* begin()
+        {
+            return payloads;
+        }
+    };
+
+    struct alignas(std::hardware_destructive_interference_size) ParkingState
+    {
+        std::atomic<std::uint32_t> consumerSignal{ 0 };
+        std::atomic<bool> consumerParked{ false };
+        std::atomic<std::uint32_t> producersParked{ 0 };
+    };
+
+    class alignas(std::hardware_destructive_interference_size) EventNotifier
+    {
+    public:
+        std::atomic<bool> armed{ false };
+        const int fd;
+
+        EventNotifier()
+            : fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+        {
+            if (-1 == fd)
+            {
+                throw std::system_error(errno, std::generic_category(), "eventfd() failed");
+            }
+        }
+
+        ~EventNotifier()
+        {
+            close(fd);
+        }
+
+        EventNotifier(const EventNotifier&) = delete;
+        EventNotifier& operator=(const EventNotifier&) = delete;
+
+        void signal()
+        {
+            const eventfd_t value = 1;
+            [[maybe_unused]] const ssize_t written = write(fd, &value, sizeof(value));
+        }
+
+        void clear()
+        {
+            eventfd_t value;
+            [[maybe_unused]] const ssize_t readBytes = read(fd, &value, sizeof(value));
+        }
+    };
+
+    struct alignas(std::hardware_destructive_interference_size) ReorderState
+    {
+        std::uint64_t consumed = 0;
+    };
+
+    // tickets dropped by producers lapped by another producer, they never carry a message
+    class AbandonedTickets
+    {
+    private:
+        static constexpr std::uint32_t STRIPES = 16;
+
+        struct alignas(std::hardware_destructive_interference_size) Stripe
+        {
+            std::atomic<std::uint64_t> count{ 0 };
+        };
+
+        Stripe stripes[STRIPES];
+        alignas(std::hardware_destructive_interference_size) std::uint64_t settled = 0;
+        std::uint64_t unsettled = 0;
+
+    public:
+        void abandon()
+        {
+            thread_local const std::uint32_t stripeId = std::hash<std::thread::id>{}(std::this_thread::get_id()) % STRIPES;
+            stripes[stripeId].count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void skipped(const std::uint64_t count)
+        {
+            unsettled += count;
+        }
+
+        // removes the abandoned tickets from the skipped ones counted in lost
+        void settle(std::uint64_t& lost)
+        {
+            if (0 == unsettled)
+            {
+                return;
+            }
+
+            std::uint64_t total = 0;
+            for (const Stripe& stripe : stripes)
+            {
+                total += stripe.count.load(std::memory_order_relaxed);
+            }
+            std::uint64_t count = total - settled;
+            count = count < unsettled ? count : unsettled;
+            count = count < lost ? count : lost;
+            lost -= count;
+            settled += count;
+            unsettled -= count;
+        }
+    };
+
+    class NoBackoff
+    {
+    public:
+        std::uint32_t wait(const void* const)
+        {
+            return 0;
+        }
+    };
+
+    template<std::uint32_t maxSpins = 1 << 6>
+    class PauseBackoff
+    {
+    private:
+        std::uint32_t spins = 1;
+
+    public:
+        std::uint32_t wait(const void* const)
+        {
+            const std::uint32_t count = spins;
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                _mm_pause();
+            }
+            spins = spins < maxSpins ? spins << 1 : maxSpins;
+            return count;
+        }
+    };
+
+    class YieldBackoff
+    {
+    public:
+        std::uint32_t wait(const void* const)
+        {
+            std::this_thread::yield();
+            return 0;
+        }
+    };
+
+    inline bool hasWaitPackage()
+    {
+        static const bool supported = []
+        {
+            unsigned int eax, ebx, ecx, edx;
+            return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 5));
+        }();
+        return supported;
+    }
+
+    [[gnu::target("waitpkg")]] inline void timedPause(const std::uint64_t deadline)
+    {
+        _tpause(1, deadline);
+    }
+
+    [[gnu::target("waitpkg")]] inline void timedWait(const void* const address, const std::uint64_t deadline)
+    {
+        _umonitor(const_cast<void*>(address));
+        _umwait(1, deadline);
+    }
+
+    inline bool hasPrefetchWrite()
+    {
+        static const bool supported = []
+        {
+            unsigned int eax, ebx, ecx, edx;
+            return __get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 8));
+        }();
+        return supported;
+    }
+
+    // GCC drops the write hint without -mprfchw, so prefetchw is emitted directly and prefetcht0 is used without it
+    inline void prefetchForWrite(const void* const address)
+    {
+#ifdef __PRFCHW__
+        asm volatile("prefetchw %0" : : "m" (*static_cast<const char*>(address)));
+#else
+        if (hasPrefetchWrite())
+        {
+            asm volatile("prefetchw %0" : : "m" (*static_cast<const char*>(address)));
+        }
+        else
+        {
+            __builtin_prefetch(address, 1, 3);
+        }
+#endif
+    }
+
+    enum class CopyKernel
+    {
+        Memcpy,
+        Avx2,
+        Avx512
+    };
+
+    inline CopyKernel copyKernel()
+    {
+#if defined(__AVX512F__)
+        return CopyKernel::Avx512;
+#else
+        static const CopyKernel kernel = __builtin_cpu_supports("avx512f") ? CopyKernel::Avx512 : __builtin_cpu_supports("avx2") ? CopyKernel::Avx2 : CopyKernel::Memcpy;
+        return kernel;
+#endif
+    }
+
+    // the last vector is copied from the end of the range, overlapping the previous one
+    [[gnu::target("avx2")]] inline void copyAvx2(char* dst, const char* src, std::size_t size, const bool nonTemporal)
+    {
+        if (size < sizeof(__m256i))
+        {
+            memcpy(dst, src, size);
+            return;
+        }
+
+        const __m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + size - sizeof(__m256i)));
+        char* const lastDst = dst + size - sizeof(__m256i);
+        if (nonTemporal)
+        {
+            const std::size_t head = -reinterpret_cast<std::uintptr_t>(dst) & (sizeof(__m256i) - 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)));
+            for (dst += head, src += head, size -= head; size >= sizeof(__m256i); dst += sizeof(__m256i), src += sizeof(__m256i), size -= sizeof(__m256i))
+            {
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(dst), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lastDst), last);
+            _mm_sfence();
+        }
+        else
+        {
+            for (; size > sizeof(__m256i); dst += sizeof(__m256i), src += sizeof(__m256i), size -= sizeof(__m256i))
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lastDst), last);
+        }
+    }
+
+    [[gnu::target("avx512f")]] inline void copyAvx512(char* dst, const char* src, std::size_t size, const bool nonTemporal)
+    {
+        if (size < sizeof(__m512i))
+        {
+            copyAvx2(dst, src, size, nonTemporal);
+            return;
+        }
+
+        const __m512i last = _mm512_loadu_si512(src + size - sizeof(__m512i));
+        char* const lastDst = dst + size - sizeof(__m512i);
+        if (nonTemporal)
+        {
+            const std::size_t head = -reinterpret_cast<std::uintptr_t>(dst) & (sizeof(__m512i) - 1);
+            _mm512_storeu_si512(dst, _mm512_loadu_si512(src));
+            for (dst += head, src += head, size -= head; size >= sizeof(__m512i); dst += sizeof(__m512i), src += sizeof(__m512i), size -= sizeof(__m512i))
+            {
+                _mm512_stream_si512(reinterpret_cast<__m512i*>(dst), _mm512_loadu_si512(src));
+            }
+            _mm512_storeu_si512(lastDst, last);
+            _mm_sfence();
+        }
+        else
+        {
+            for (; size > sizeof(__m512i); dst += sizeof(__m512i), src += sizeof(__m512i), size -= sizeof(__m512i))
+            {
+                _mm512_storeu_si512(dst, _mm512_loadu_si512(src));
+            }
+            _mm512_storeu_si512(lastDst, last);
+        }
+    }
+
+    inline void copy(void* const dst, const void* const src, const std::size_t size, const bool nonTemporal)
+    {
+        switch (copyKernel())
+        {
+        case CopyKernel::Avx512:
+            copyAvx512(static_cast<char*>(dst), static_cast<const char*>(src), size, nonTemporal);
+            break;
+        case CopyKernel::Avx2:
+            copyAvx2(static_cast<char*>(dst), static_cast<const char*>(src), size, nonTemporal);
+            break;
+        default:
+            memcpy(dst, src, size);
+        }
+    }
+
+    // waits up to maxCycles in the C0.1 state with tpause, falls back to PauseBackoff without WAITPKG support
+    template<std::uint32_t maxCycles = 1 << 12>
+    class TpauseBackoff
+    {
+    private:
+        std::uint32_t cycles = 1 << 6;
+        PauseBackoff<> fallback;
+
+    public:
+        std::uint32_t wait(const void* const address)
+        {
+            if (!hasWaitPackage())
+            {
+                return fallback.wait(address);
+            }
+            timedPause(__rdtsc() + cycles);
+            cycles = cycles < maxCycles ? cycles << 1 : maxCycles;
+            return 0;
+        }
+    };
+
+    // sleeps until the cache line of the watched address is written or maxCycles pass
+    template<std::uint32_t maxCycles = 1 << 12>
+    class UmwaitBackoff
+    {
+    private:
+        PauseBackoff<> fallback;
+
+    public:
+        std::uint32_t wait(const void* const address)
+        {
+            if (!hasWaitPackage())
+            {
+                return fallback.wait(address);
+            }
+            timedWait(address, __rdtsc() + maxCycles);
+            return 0;
+        }
+    };
+
+    struct TscClock
+    {
+        static std::uint64_t now()
+        {
+            return __rdtsc();
+        }
+    };
+
+    struct SteadyClock
+    {
+        static std::uint64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    };
+
+    // bin i of the histogram counts delays of i significant bits
+    struct DelayInterval
+    {
+        static constexpr std::uint32_t BINS = 65;
+
+        std::uint64_t count = 0;
+        std::uint64_t sum = 0;
+        std::uint64_t min = 0;
+        std::uint64_t max = 0;
+        std::uint64_t histogram[BINS] = { 0 };
+
+        std::uint64_t average() const
+        {
+            return count ? sum / count : 0;
+        }
+    };
+
+    class DelayTracker
+    {
+    private:
+        DelayInterval current;
+
+    public:
+        void record(const std::uint64_t delay)
+        {
+            if (0 == current.count || delay < current.min)
+            {
+                current.min = delay;
+            }
+            if (delay > current.max)
+            {
+                current.max = delay;
+            }
+            ++current.count;
+            current.sum += delay;
+            ++current.histogram[delay ? 64 - __builtin_clzll(delay) : 0];
+        }
+
+        DelayInterval collect()
+        {
+            const DelayInterval interval = current;
+            current = {};
+            return interval;
+        }
+    };
+
+    struct Statistics
+    {
+        std::uint64_t casFailures = 0;
+        std::uint64_t pauseSpins = 0;
+        std::uint64_t fullRejections = 0;
+        std::uint64_t emptyPeeks = 0;
+        std::uint64_t highWatermark = 0;
+
+        // merges the statistics of another buffer, the high watermarks are not summed
+        Statistics& operator+=(const Statistics& other)
+        {
+            casFailures += other.casFailures;
+            pauseSpins += other.pauseSpins;
+            fullRejections += other.fullRejections;
+            emptyPeeks += other.emptyPeeks;
+            highWatermark = other.highWatermark > highWatermark ? other.highWatermark : highWatermark;
+            return *this;
+        }
+    };
+
+    class StatisticsCounters
+    {
+    private:
+        static constexpr std::uint32_t STRIPES = 16;
+
+        struct alignas(std::hardware_destructive_interference_size) Stripe
+        {
+            std::atomic<std::uint64_t> casFailures{ 0 };
+            std::atomic<std::uint64_t> pauseSpins{ 0 };
+            std::atomic<std::uint64_t> fullRejections{ 0 };
+            std::atomic<std::uint64_t> highWatermark{ 0 };
+        };
+
+        Stripe stripes[STRIPES];
+        alignas(std::hardware_destructive_interference_size) std::atomic<std::uint64_t> emptyPeeks{ 0 };
+
+        Stripe& stripe()
+        {
+            thread_local const std::uint32_t stripeId = std::hash<std::thread::id>{}(std::this_thread::get_id()) % STRIPES;
+            return stripes[stripeId];
+        }
+
+    public:
+        void casFailure()
+        {
+            stripe().casFailures.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void pauseSpins(const std::uint32_t count)
+        {
+            stripe().pauseSpins.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void fullRejection()
+        {
+            stripe().fullRejections.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void emptyPeek()
+        {
+            emptyPeeks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void occupancy(const std::uint64_t usedCount)
+        {
+            std::atomic<std::uint64_t>& highWatermark = stripe().highWatermark;
+            std::uint64_t current = highWatermark.load(std::memory_order_relaxed);
+            while (usedCount > current && !highWatermark.compare_exchange_weak(current, usedCount, std::memory_order_relaxed, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        Statistics read() const
+        {
+            Statistics statistics;
+            for (const Stripe& stripe : stripes)
+            {
+                statistics.casFailures += stripe.casFailures.load(std::memory_order_relaxed);
+                statistics.pauseSpins += stripe.pauseSpins.load(std::memory_order_relaxed);
+                statistics.fullRejections += stripe.fullRejections.load(std::memory_order_relaxed);
+                const std::uint64_t highWatermark = stripe.highWatermark.load(std::memory_order_relaxed);
+                statistics.highWatermark = highWatermark > statistics.highWatermark ? highWatermark : statistics.highWatermark;
+            }
+            statistics.emptyPeeks = emptyPeeks.load(std::memory_order_relaxed);
+            return statistics;
+        }
+    };
+}
+
+struct BRingBufferTraits
+{
+    static constexpr brb::Layout layout = brb::Layout::Padded;
+    static constexpr brb::Engine engine = brb::Engine::Cas;
+    static constexpr bool cacheReadHead = false;
+    static constexpr bool singleProducer = false;
+    static constexpr bool parking = false;
+    static constexpr bool eventNotifier = false;
+    static constexpr bool statistics = false;
+    static constexpr bool timestamps = false;
+    using clock = brb::TscClock;
+    static constexpr bool overwrite = false;
+    static constexpr std::uint32_t reorderWindow = 0;
+    static constexpr std::uint32_t prefetchDistance = 0;
+    static constexpr std::uint32_t nonTemporalSize = 0;
+    using backoff = brb::PauseBackoff<>;
+    static constexpr std::uint32_t waitSpins = 1 << 4;
+    static constexpr std::uint32_t waitYields = 1 << 4;
+};
+
+template<std::uint32_t staticCapacity, std::uint32_t maxDataSize, typename Traits = BRingBufferTraits>
 class BRingBuffer
 {
 private:
+    static constexpr bool SEQUENCE = brb::Engine::Sequence == Traits::engine;
+    static constexpr bool MONOTONIC = SEQUENCE || brb::DYNAMIC == staticCapacity || 0 == (staticCapacity & (staticCapacity - 1));
+    static constexpr bool CACHE_READ_HEAD = Traits::cacheReadHead;
+    static constexpr bool SINGLE_PRODUCER = Traits::singleProducer;
+    static constexpr bool PARKING = Traits::parking;
+    static constexpr bool EVENT_NOTIFIER = Traits::eventNotifier;
+    static constexpr bool STATISTICS = Traits::statistics;
+    static constexpr bool TIMESTAMPS = Traits::timestamps;
+    static constexpr bool OVERWRITE = Traits::overwrite;
+    static constexpr std::uint32_t REORDER_WINDOW = Traits::reorderWindow;
+    static constexpr std::uint32_t PREFETCH_DISTANCE = Traits::prefetchDistance;
+    static constexpr std::uint32_t NON_TEMPORAL_SIZE = Traits::nonTemporalSize;
+
+    using Flag = std::conditional_t<SEQUENCE, std::atomic<std::uint64_t>, std::atomic<bool>>;
+    using Storage = brb::Storage<Traits::layout, Flag, staticCapacity, maxDataSize, std::conditional_t<TIMESTAMPS, std::uint64_t, brb::Empty<0>>>;
+    using Backoff = typename Traits::backoff;
+
     alignas (std::hardware_destructive_interference_size) std::atomic<std::uint64_t> readHead{ 0 };
     alignas (std::hardware_destructive_interference_size) std::atomic<std::uint64_t> writeHead{ 0 };
+    std::atomic<std::uint64_t> cachedReadHead{ 0 };
+    // the runtime sized storage keeps its capacity and pointers here, off the cache line of the write position
+    alignas (std::hardware_destructive_interference_size) Storage data;
+    [[no_unique_address]] std::conditional_t<PARKING, brb::ParkingState, brb::Empty<1>> parking;
+    [[no_unique_address]] std::conditional_t<EVENT_NOTIFIER, brb::EventNotifier, brb::Empty<2>> notifier;
+    [[no_unique_address]] std::conditional_t<STATISTICS, brb::StatisticsCounters, brb::Empty<3>> counters;
+    [[no_unique_address]] std::conditional_t<0 != REORDER_WINDOW, brb::ReorderState, brb::Empty<4>> reorder;
+    [[no_unique_address]] std::conditional_t<OVERWRITE, brb::AbandonedTickets, brb::Empty<5>> abandoned;
+
+    static constexpr std::uint64_t WRAP_COUNT_INCR = 0x0000000100000000;
+    static constexpr std::uint64_t WRAP_COUNT_MASK = 0xFFFFFFFF00000000;
+    static constexpr std::uint64_t INDEX_MASK = 0x00000000FFFFFFFF;
+
+    static constexpr std::uint32_t bucketsForRecord(const std::uint32_t dataSize)
+    {
+        return dataSize <= maxDataSize ? 1 : (Storage::OFFSET_TO_PAYLOAD + dataSize + Storage::STRIDE - 1) / Storage::STRIDE;
+    }
+
+public:
+    struct Span
+    {
+        void* first = nullptr;
+        std::uint32_t firstSize = 0;
+        void* second = nullptr;
+        std::uint32_t secondSize = 0;
+    };
+
+    BRingBuffer()
+    {
+        static_assert(brb::DYNAMIC != staticCapacity, "capacity must be given to the constructor");
+        static_assert(offsetof(BRingBuffer, data) >= offsetof(BRingBuffer, writeHead) + std::hardware_destructive_interference_size, "storage shares the cache line of the write position");
+        initSequences();
+    }
+
+    explicit BRingBuffer(const std::uint32_t capacity, const brb::MemoryOptions& options = {})
+        : data(capacity, options)
+    {
+        static_assert(brb::DYNAMIC == staticCapacity, "capacity is given by the template parameter");
+        static_assert(offsetof(BRingBuffer, data) >= offsetof(BRingBuffer, writeHead) + std::hardware_destructive_interference_size, "storage shares the cache line of the write position");
+        initSequences();
+    }
+
+    std::uint32_t capacity() const
+    {
+        return data.bucketCount();
+    }
+
+    static constexpr std::uint32_t MAX_DATA_SIZE = maxDataSize;
+    static constexpr std::size_t PAYLOAD_ALIGNMENT = (Storage::OFFSET_TO_PAYLOAD | Storage::STRIDE | std::hardware_destructive_interference_size) & -(Storage::OFFSET_TO_PAYLOAD | Storage::STRIDE | std::hardware_destructive_interference_size);
+
+    std::uint32_t maxRecordSize() const
+    {
+        return capacity() * Storage::STRIDE - Storage::OFFSET_TO_PAYLOAD;
+    }
+
+    void* reserve(const std::uint32_t dataSize)
+    {
+        if constexpr (OVERWRITE)
+        {
+            static_assert(SEQUENCE, "overwrite requires the sequence engine");
+            Backoff backoff;
+
+            while (true)
+            {
+                // a bucket of ticket t holds 2t + 1 while it is written and 2t + 2 once committed
+                const std::uint64_t ticket = takeTickets(1);
+                const std::uint32_t freeId = data.bucketIndex(ticket);
+                Flag& sequence = data.flag(freeId);
+                std::uint64_t current = sequence.load(std::memory_order_relaxed);
+
+                while (current < 2 * ticket + 1)
+                {
+                    if (current & 1)
+                    {
+                        wait(backoff, &sequence);
+                        current = sequence.load(std::memory_order_relaxed);
+                    }
+                    else if (sequence.compare_exchange_weak(current, 2 * ticket + 1, std::memory_order_relaxed, std::memory_order_relaxed))
+                    {
+                        std::atomic_thread_fence(std::memory_order_release);
+                        prefetchBucket(freeId, dataSize);
+                        data.size(freeId) = dataSize;
+                        return data.payload(freeId);
+                    }
+                }
+                // a producer a whole lap ahead took the bucket, the reader skips this ticket without counting it as lost
+                abandoned.abandon();
+            }
+        }
+        else if constexpr (SEQUENCE)
+        {
+            std::uint64_t currentReadHead = CACHE_READ_HEAD ? cachedReadHead.load(std::memory_order_acquire) : readHead.load(std::memory_order_acquire);
+            if (writeHead.load(std::memory_order_relaxed) - currentReadHead >= capacity())
+            {
+                if constexpr (CACHE_READ_HEAD)
+                {
+                    currentReadHead = readHead.load(std::memory_order_acquire);
+                    cachedReadHead.store(currentReadHead, std::memory_order_release);
+                }
+
+                if (!CACHE_READ_HEAD || writeHead.load(std::memory_order_relaxed) - currentReadHead >= capacity())
+                {
+                    countFullRejection();
+                    return nullptr;
+                }
+            }
+
+            const std::uint64_t ticket = takeTickets(1);
+            const std::uint32_t freeId = data.bucketIndex(ticket);
+            countOccupancy(ticket + 1, currentReadHead);
+            waitForSequence(data.flag(freeId), ticket);
+
+            prefetchBucket(freeId, dataSize);
+            data.size(freeId) = dataSize;
+            return data.payload(freeId);
+        }
+        else
+        {
+            std::uint64_t currentWriteHead, currentReadHead, newWriteHead;
+            std::uint32_t freeId, readId;
+
+            Backoff backoff;
+            currentWriteHead = writeHead.load(std::memory_order_relaxed);
+            if constexpr (CACHE_READ_HEAD)
+            {
+                currentReadHead = cachedReadHead.load(std::memory_order_acquire);
+            }
+
+            while (true)
+            {
+                newWriteHead = currentWriteHead;
+                if constexpr (!CACHE_READ_HEAD)
+                {
+                    currentReadHead = readHead.load(std::memory_order_acquire);
+                }
+
+                freeId = writeIndex(newWriteHead);
+
+                if constexpr (CACHE_READ_HEAD)
+                {
+                    // the cached read position may be older than the one used by other producers
+                    if (usedCount(newWriteHead, currentReadHead) >= capacity())
+                    {
+                        // the read position may also be newer than the write position loaded before it
+                        const std::uint64_t freshWriteHead = writeHead.load(std::memory_order_relaxed);
+                        if (freshWriteHead != currentWriteHead)
+                        {
+                            currentWriteHead = freshWriteHead;
+                            continue;
+                        }
+                        const std::uint64_t freshReadHead = readHead.load(std::memory_order_acquire);
+                        if (freshReadHead == currentReadHead)
+                        {
+                            countFullRejection();
+                            return nullptr;
+                        }
+                        currentReadHead = freshReadHead;
+                        cachedReadHead.store(freshReadHead, std::memory_order_release);
+                        continue;
+                    }
+                }
+                else if constexpr (MONOTONIC)
+                {
+                    // the read position may be newer than the write position loaded before it
+                    if (currentReadHead > newWriteHead)
+                    {
+                        currentWriteHead = writeHead.load(std::memory_order_relaxed);
+                        continue;
+                    }
+                    if (newWriteHead - currentReadHead >= capacity())
+                    {
+                        countFullRejection();
+                        return nullptr;
+                    }
+                }
+                else
+                {
+                    readId = currentReadHead & INDEX_MASK;
+                    if (WRAP_COUNT_INCR == (newWriteHead & WRAP_COUNT_MASK) - (currentReadHead & WRAP_COUNT_MASK) && readId == freeId)
+                    {
+                        countFullRejection();
+                        return nullptr;
+                    }
+                }
+                ++newWriteHead;
+
+                if (advanceWriteHead(currentWriteHead, newWriteHead))
+                {
+                    break;
+                }
+
+                countCasFailure();
+                wait(backoff, &writeHead);
+            }
+
+            countOccupancy(newWriteHead, currentReadHead);
+            prefetchBucket(freeId, dataSize);
+            data.size(freeId) = dataSize;
+            return data.payload(freeId);
+        }
+    }
+
+    void commit(void* const dataPtr)
+    {
+        if constexpr (TIMESTAMPS)
+        {
+            data.timestamp(dataPtr) = Traits::clock::now();
+        }
+        commitBucket(dataPtr);
+        notifyConsumer();
+    }
+
+    void commit(void* const dataPtr, const std::uint32_t dataSize)
+    {
+        data.size(dataPtr) = dataSize;
+        commit(dataPtr);
+    }
+
+    bool push(const void* const src, const std::uint32_t dataSize)
+    {
+        if (dataSize > maxDataSize)
+        {
+            return false;
+        }
+
+        void* const dataPtr = reserve(dataSize);
+        if (nullptr == dataPtr)
+        {
+            return false;
+        }
+
+        brb::copy(dataPtr, src, dataSize, 0 != NON_TEMPORAL_SIZE && dataSize >= NON_TEMPORAL_SIZE);
+        commit(dataPtr);
+        return true;
+    }
+
+    std::uint32_t reserveBatch(void** const dataPtrs, const std::uint32_t count, const std::uint32_t dataSize)
+    {
+        static_assert(!OVERWRITE, "overwrite buffers are read with take()");
+        if constexpr (SEQUENCE)
+        {
+            const std::uint64_t currentReadHead = readHead.load(std::memory_order_acquire);
+            const std::uint64_t usedCount = writeHead.load(std::memory_order_relaxed) - currentReadHead;
+            std::uint32_t reserved = usedCount < capacity() ? capacity() - usedCount : 0;
+            if (count < reserved)
+            {
+                reserved = count;
+            }
+
+            if (0 == reserved)
+            {
+                countFullRejection();
+                return 0;
+            }
+
+            const std::uint64_t ticket = takeTickets(reserved);
+            countOccupancy(ticket + reserved, currentReadHead);
+            for (std::uint32_t i = 0; i < reserved; ++i)
+            {
+                const std::uint32_t freeId = data.bucketIndex(ticket + i);
+                waitForSequence(data.flag(freeId), ticket + i);
+                data.size(freeId) = dataSize;
+                dataPtrs[i] = data.payload(freeId);
+            }
+            return reserved;
+        }
+        else
+        {
+            std::uint64_t currentWriteHead, currentReadHead, newWriteHead;
+            std::uint32_t freeId, readId, reserved;
+
+            Backoff backoff;
+            currentWriteHead = writeHead.load(std::memory_order_relaxed);
+
+            while (true)
+            {
+                newWriteHead = currentWriteHead;
+                currentReadHead = readHead.load(std::memory_order_acquire);
+
+                freeId = writeIndex(newWriteHead);
+
+                if constexpr (MONOTONIC)
+                {
+                    if (currentReadHead > newWriteHead)
+                    {
+                        currentWriteHead = writeHead.load(std::memory_order_relaxed);
+                        continue;
+                    }
+                    const std::uint32_t freeCount = capacity() - (newWriteHead - currentReadHead);
+                    reserved = freeCount < capacity() - freeId ? freeCount : capacity() - freeId;
+                }
+                else
+                {
+                    readId = currentReadHead & INDEX_MASK;
+                    reserved = (newWriteHead & WRAP_COUNT_MASK) == (currentReadHead & WRAP_COUNT_MASK) ? capacity() - freeId : readId - freeId;
+                }
+                if (count < reserved)
+                {
+                    reserved = count;
+                }
+
+                if (0 == reserved)
+                {
+                    countFullRejection();
+                    return 0;
+                }
+                newWriteHead += reserved;
+
+                if (advanceWriteHead(currentWriteHead, newWriteHead))
+                {
+                    break;
+                }
+
+                countCasFailure();
+                wait(backoff, &writeHead);
+            }
+
+            countOccupancy(newWriteHead, currentReadHead);
+            for (std::uint32_t i = 0; i < reserved; ++i)
+            {
+                data.size(freeId + i) = dataSize;
+                dataPtrs[i] = data.payload(freeId + i);
+            }
+            return reserved;
+        }
+    }
+
+    void commitBatch(void* const* const dataPtrs, const std::uint32_t count)
+    {
+        if constexpr (TIMESTAMPS)
+        {
+            const std::uint64_t now = Traits::clock::now();
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                data.timestamp(dataPtrs[i]) = now;
+            }
+        }
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            commitBucket(dataPtrs[i]);
+        }
+        notifyConsumer();
+    }
+
+    bool reserveRecord(Span& span, const std::uint32_t dataSize)
+    {
+        static_assert(!SEQUENCE, "records are not supported by the sequence engine");
+        std::uint64_t currentWriteHead, currentReadHead, newWriteHead;
+        std::uint32_t freeId, readId, freeCount;
+        const std::uint32_t bucketCount = bucketsForRecord(dataSize);
+
+        Backoff backoff;
+        currentWriteHead = writeHead.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            newWriteHead = currentWriteHead;
+            currentReadHead = readHead.load(std::memory_order_acquire);
+
+            freeId = writeIndex(newWriteHead);
+
+            if constexpr (MONOTONIC)
+            {
+                if (currentReadHead > newWriteHead)
+                {
+                    currentWriteHead = writeHead.load(std::memory_order_relaxed);
+                    continue;
+                }
+                freeCount = capacity() - (newWriteHead - currentReadHead);
+            }
+            else
+            {
+                readId = currentReadHead & INDEX_MASK;
+                freeCount = (newWriteHead & WRAP_COUNT_MASK) == (currentReadHead & WRAP_COUNT_MASK) ? capacity() - freeId + readId : readId - freeId;
+            }
+
+            if (freeCount < bucketCount)
+            {
+                countFullRejection();
+                return false;
+            }
+
+            if (MONOTONIC || freeId + bucketCount <= capacity())
+            {
+                newWriteHead += bucketCount;
+            }
+            else
+            {
+                newWriteHead = (newWriteHead & WRAP_COUNT_MASK) + WRAP_COUNT_INCR + freeId + bucketCount - capacity();
+            }
+
+            if (advanceWriteHead(currentWriteHead, newWriteHead))
+            {
+                break;
+            }
+
+            countCasFailure();
+            wait(backoff, &writeHead);
+        }
+
+        countOccupancy(newWriteHead, currentReadHead);
+        data.size(freeId) = dataSize;
+        fillSpan(span, freeId, dataSize);
+        return true;
+    }
+
+    void commitRecord(const Span& span)
+    {
+        commit(span.first);
+    }
+
+    void* peek(std::uint32_t& dataSize, const std::uint64_t magicId)
+    {
+        static_assert(!OVERWRITE, "overwrite buffers are read with take()");
+        const std::uint32_t readId = readIndex(magicId);
+
+        if (!committed(readId, magicId))
+        {
+            countEmptyPeek();
+            return nullptr;
+        }
+
+        dataSize = data.size(readId);
+        return data.payload(readId);
+    }
+
+    void decommit(void* const dataPtr, std::uint64_t& magicId)
+    {
+        if constexpr (SEQUENCE)
+        {
+            data.flag(dataPtr).store(magicId + capacity(), std::memory_order_release);
+            publishReadHead(++magicId);
+            prefetchAhead(magicId);
+        }
+        else
+        {
+            const std::uint32_t readId = readIndex(magicId);
+            std::uint64_t newRead = magicId + 1;
+
+            if (!MONOTONIC && capacity() == readId + 1)
+            {
+                newRead = (magicId & WRAP_COUNT_MASK) + WRAP_COUNT_INCR;
+            }
+            magicId = newRead;
+            data.flag(dataPtr).store(false, std::memory_order_relaxed);
+            publishReadHead(newRead);
+            prefetchAhead(newRead);
+        }
+    }
+
+    bool pop(void* const dst, const std::uint32_t dstSize, std::uint32_t& dataSize, std::uint64_t& magicId)
+    {
+        void* const dataPtr = peek(dataSize, magicId);
+        if (nullptr == dataPtr || dataSize > dstSize)
+        {
+            return false;
+        }
+
+        brb::copy(dst, dataPtr, dataSize, false);
+        decommit(dataPtr, magicId);
+        return true;
+    }
+
+    bool peekRecord(Span& span, std::uint32_t& dataSize, const std::uint64_t magicId)
+    {
+        static_assert(!SEQUENCE, "records are not supported by the sequence engine");
+        const std::uint32_t readId = readIndex(magicId);
+
+        if (!data.flag(readId).load(std::memory_order_acquire))
+        {
+            countEmptyPeek();
+            return false;
+        }
+
+        dataSize = data.size(readId);
+        fillSpan(span, readId, dataSize);
+        return true;
+    }
+
+    void decommitRecord(std::uint64_t& magicId)
+    {
+        static_assert(!SEQUENCE, "records are not supported by the sequence engine");
+        const std::uint32_t readId = readIndex(magicId);
+        const std::uint32_t bucketCount = bucketsForRecord(data.size(readId));
+        std::uint64_t newRead = magicId + bucketCount;
+
+        if (!MONOTONIC && capacity() <= readId + bucketCount)
+        {
+            newRead = (magicId & WRAP_COUNT_MASK) + WRAP_COUNT_INCR + readId + bucketCount - capacity();
+        }
+        magicId = newRead;
+        for (std::uint32_t i = 0, id = readId; i < bucketCount; ++i, id = id + 1 == capacity() ? 0 : id + 1)
+        {
+            data.flag(id).store(false, std::memory_order_relaxed);
+        }
+        publishReadHead(newRead);
+    }
 
-    struct alignas(std::hardware_destructive_interference_size) Bucket
+    std::uint32_t peekBatch(void** const dataPtrs, std::uint32_t* const dataSizes, const std::uint32_t maxCount, const std::uint64_t magicId)
     {
-        std::atomic<bool> used{ false };
-        std::uint32_t size = 0;
-        char payload[maxDataSize] = { 0 };
-    };
-    Bucket data[capacity];
+        static_assert(!OVERWRITE, "overwrite buffers are read with take()");
+        const std::uint32_t readId = readIndex(magicId);
+        const std::uint32_t limit = maxCount < capacity() - readId ? maxCount : capacity() - readId;
 
-    static constexpr std::uint32_t OFFSET_TO_USED = offsetof(Bucket, payload);
-    static constexpr std::uint64_t WRAP_COUNT_INCR = 0x0000000100000000;
-    static constexpr std::uint64_t WRAP_COUNT_MASK = 0xFFFFFFFF00000000;
-    static constexpr std::uint64_t INDEX_MASK = 0x00000000FFFFFFFF;
-    static constexpr std::uint32_t MAX_BACKOFF = 1 << 6;
+        std::uint32_t count = 0;
+        while (count < limit && committed(readId + count, magicId + count))
+        {
+            dataSizes[count] = data.size(readId + count);
+            dataPtrs[count] = data.payload(readId + count);
+            ++count;
+        }
 
-public:
-    void* reserve(const std::uint32_t dataSize)
+        if (0 == count)
+        {
+            countEmptyPeek();
+        }
+        return count;
+    }
+
+    void decommitBatch(const std::uint32_t count, std::uint64_t& magicId)
     {
-        std::uint64_t currentWriteHead, currentReadHead, newWriteHead;
-        std::uint32_t freeId, readId;
+        if (0 == count)
+        {
+            return;
+        }
 
-        std::uint32_t backoffCount = 1;
-        currentWriteHead = writeHead.load(std::memory_order_relaxed);
+        if constexpr (SEQUENCE)
+        {
+            const std::uint32_t readId = readIndex(magicId);
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                data.flag(readId + i).store(magicId + i + capacity(), std::memory_order_release);
+            }
+            magicId += count;
+            publishReadHead(magicId);
+            prefetchAhead(magicId);
+        }
+        else
+        {
+            const std::uint32_t readId = readIndex(magicId);
+            std::uint64_t newRead = magicId + count;
 
-        while (true)
+            if (!MONOTONIC && capacity() == readId + count)
+            {
+                newRead = (magicId & WRAP_COUNT_MASK) + WRAP_COUNT_INCR;
+            }
+            magicId = newRead;
+            for (std::uint32_t i = readId; i < readId + count; ++i)
+            {
+                data.flag(i).store(false, std::memory_order_relaxed);
+            }
+            publishReadHead(newRead);
+            prefetchAhead(newRead);
+        }
+    }
+
+    void* peekUnordered(std::uint32_t& dataSize, const std::uint64_t magicId)
+    {
+        static_assert(0 != REORDER_WINDOW && REORDER_WINDOW <= 64, "reorderWindow must be between 1 and 64");
+        static_assert(!OVERWRITE, "overwrite buffers are read with take()");
+        const std::uint32_t readId = readIndex(magicId);
+        const std::uint32_t window = REORDER_WINDOW < capacity() ? REORDER_WINDOW : capacity();
+
+        const auto readyId = [&](const std::uint32_t i)
         {
-            newWriteHead = currentWriteHead;
-            currentReadHead = readHead.load(std::memory_order_acquire);
+            const std::uint32_t id = readId + i < capacity() ? readId + i : readId + i - capacity();
+            return !(reorder.consumed & (1ull << i)) && committed(id, magicId + i) ? id : capacity();
+        };
+
+        for (std::uint32_t i = 0; i < window; ++i)
+        {
+            std::uint32_t id = readyId(i);
+            if (capacity() != id)
+            {
+                // an older bucket skipped above may have been committed since, by the producer of this one
+                for (std::uint32_t j = 0; j < i; ++j)
+                {
+                    const std::uint32_t olderId = readyId(j);
+                    if (capacity() != olderId)
+                    {
+                        id = olderId;
+                        break;
+                    }
+                }
+                dataSize = data.size(id);
+                return data.payload(id);
+            }
+        }
+
+        countEmptyPeek();
+        return nullptr;
+    }
+
+    void decommitUnordered(void* const dataPtr, std::uint64_t& magicId)
+    {
+        static_assert(0 != REORDER_WINDOW && REORDER_WINDOW <= 64, "reorderWindow must be between 1 and 64");
+        const std::uint32_t readId = readIndex(magicId);
+        const std::uint32_t consumedId = bucketId(dataPtr);
+        reorder.consumed |= 1ull << (consumedId >= readId ? consumedId - readId : consumedId + capacity() - readId);
+
+        // the buckets consumed out of order stay used until the read position passes them
+        std::uint32_t count = 0;
+        while (count < 64 && (reorder.consumed & (1ull << count)))
+        {
+            ++count;
+        }
+        if (0 == count)
+        {
+            return;
+        }
+        reorder.consumed = 64 == count ? 0 : reorder.consumed >> count;
 
-            freeId = currentWriteHead & INDEX_MASK;
-            if (capacity == freeId)
+        for (std::uint32_t i = 0, id = readId; i < count; ++i, id = id + 1 == capacity() ? 0 : id + 1)
+        {
+            if constexpr (SEQUENCE)
+            {
+                data.flag(id).store(magicId + i + capacity(), std::memory_order_release);
+            }
+            else
             {
-                newWriteHead = (currentWriteHead & WRAP_COUNT_MASK) + WRAP_COUNT_INCR;
-                freeId = 0;
+                data.flag(id).store(false, std::memory_order_relaxed);
             }
+        }
+
+        std::uint64_t newRead = magicId + count;
+        if (!MONOTONIC && capacity() <= readId + count)
+        {
+            newRead = (magicId & WRAP_COUNT_MASK) + WRAP_COUNT_INCR + readId + count - capacity();
+        }
+        magicId = newRead;
+        publishReadHead(newRead);
+    }
+
+    void* claim(std::uint32_t& dataSize, std::uint64_t& ticket)
+    {
+        static_assert(SEQUENCE, "multiple consumers require the sequence engine");
+        static_assert(!OVERWRITE, "overwrite buffers are read with take()");
+        Backoff backoff;
+        std::uint64_t currentReadHead = readHead.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            const std::uint32_t readId = readIndex(currentReadHead);
+            const std::int64_t difference = data.flag(readId).load(std::memory_order_acquire) - (currentReadHead + 1);
 
-            readId = currentReadHead & INDEX_MASK;
-            if (WRAP_COUNT_INCR == (newWriteHead & WRAP_COUNT_MASK) - (currentReadHead & WRAP_COUNT_MASK) && readId == freeId)
+            if (0 == difference)
             {
+                if (readHead.compare_exchange_strong(currentReadHead, currentReadHead + 1, std::memory_order_relaxed, std::memory_order_relaxed))
+                {
+                    notifyProducers();
+                    ticket = currentReadHead;
+                    dataSize = data.size(readId);
+                    return data.payload(readId);
+                }
+
+                wait(backoff, &readHead);
+            }
+            else if (difference < 0)
+            {
+                countEmptyPeek();
                 return nullptr;
             }
-            ++newWriteHead;
+            else
+            {
+                currentReadHead = readHead.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void release(void* const dataPtr, const std::uint64_t ticket)
+    {
+        static_assert(SEQUENCE, "multiple consumers require the sequence engine");
+        data.flag(dataPtr).store(ticket + capacity(), std::memory_order_release);
+    }
+
+    bool take(void* const dst, std::uint32_t& dataSize, std::uint64_t& magicId, std::uint64_t& lost)
+    {
+        static_assert(OVERWRITE, "take() requires overwrite enabled in Traits");
 
-            if (writeHead.compare_exchange_strong(currentWriteHead, newWriteHead, std::memory_order_relaxed, std::memory_order_relaxed))
+        while (true)
+        {
+            Flag& sequence = data.flag(data.bucketIndex(magicId));
+            const std::uint64_t before = sequence.load(std::memory_order_acquire);
+
+            if (before < 2 * magicId + 2)
             {
-                break;
+                abandoned.settle(lost);
+                countEmptyPeek();
+                return false;
             }
 
-            while (backoffCount--)
+            if (before == 2 * magicId + 2)
             {
-                asm volatile("pause");
+                const std::uint32_t size = data.size(data.bucketIndex(magicId));
+                dataSize = size < maxDataSize ? size : maxDataSize;
+                memcpy(dst, data.payload(data.bucketIndex(magicId)), dataSize);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == before)
+                {
+                    ++magicId;
+                    return true;
+                }
             }
-            backoffCount = backoffCount < MAX_BACKOFF ? backoffCount << 1 : MAX_BACKOFF;
+
+            // overrun, skip to the oldest bucket of the last lap
+            const std::uint64_t oldest = writeHead.load(std::memory_order_relaxed) - capacity();
+            const std::uint64_t next = oldest > magicId + 1 ? oldest : magicId + 1;
+            lost += next - magicId;
+            abandoned.skipped(next - magicId);
+            abandoned.settle(lost);
+            magicId = next;
         }
+    }
 
-        data[freeId].size = dataSize;
-        return &data[freeId].payload;
+    bool drained(const std::uint64_t magicId)
+    {
+        std::uint64_t currentWriteHead = writeHead.load(std::memory_order_relaxed);
+        if constexpr (!MONOTONIC)
+        {
+            writeIndex(currentWriteHead);
+        }
+        return currentWriteHead == magicId;
     }
 
-    void commit(void* const dataPtr)
+    std::uint64_t timestamp(void* const dataPtr)
     {
-        reinterpret_cast<Bucket*>((static_cast<char*>(dataPtr) - OFFSET_TO_USED))->used.store(true, std::memory_order_release);
+        static_assert(TIMESTAMPS, "timestamps require timestamps enabled in Traits");
+        return data.timestamp(dataPtr);
     }
 
-    void* peek(std::uint32_t& dataSize, const std::uint64_t magicId)
+    brb::Statistics statistics() const
     {
-        const std::uint32_t readId = magicId & INDEX_MASK;
+        static_assert(STATISTICS, "statistics require statistics enabled in Traits");
+        return counters.read();
+    }
+
+    void* reserveWait(const std::uint32_t dataSize)
+    {
+        static_assert(PARKING, "waiting requires parking enabled in Traits");
+        void* dataPtr = spinThenYield([&] { return reserve(dataSize); }, &readHead);
 
-        if (!data[readId].used.load(std::memory_order_acquire))
+        while (nullptr == dataPtr)
         {
-            return nullptr;
+            const std::uint64_t currentReadHead = readHead.load(std::memory_order_acquire);
+            parking.producersParked.fetch_add(1, std::memory_order_seq_cst);
+            dataPtr = reserve(dataSize);
+            if (nullptr == dataPtr)
+            {
+                readHead.wait(currentReadHead, std::memory_order_acquire);
+                dataPtr = reserve(dataSize);
+            }
+            parking.producersParked.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return dataPtr;
+    }
+
+    void* peekWait(std::uint32_t& dataSize, const std::uint64_t magicId)
+    {
+        static_assert(PARKING, "waiting requires parking enabled in Traits");
+        void* dataPtr = spinThenYield([&] { return peek(dataSize, magicId); }, &data.flag(readIndex(magicId)));
+
+        if (nullptr == dataPtr)
+        {
+            const std::uint32_t signal = parking.consumerSignal.load(std::memory_order_acquire);
+            parking.consumerParked.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            dataPtr = peek(dataSize, magicId);
+            if (nullptr == dataPtr)
+            {
+                parking.consumerSignal.wait(signal, std::memory_order_acquire);
+                dataPtr = peek(dataSize, magicId);
+            }
+            parking.consumerParked.store(false, std::memory_order_relaxed);
         }
+        return dataPtr;
+    }
+
+    void wake()
+    {
+        static_assert(PARKING, "waiting requires parking enabled in Traits");
+        parking.consumerSignal.fetch_add(1, std::memory_order_release);
+        parking.consumerSignal.notify_one();
+    }
 
-        dataSize = data[readId].size;
-        return &data[readId].payload;
+    int eventDescriptor() const
+    {
+        static_assert(EVENT_NOTIFIER, "eventDescriptor() requires eventNotifier enabled in Traits");
+        return notifier.fd;
     }
 
-    void decommit(void* const dataPtr, std::uint64_t& magicId)
+    bool arm(const std::uint64_t magicId)
     {
-        const std::uint32_t readId = magicId & INDEX_MASK;
-        std::uint64_t newRead = magicId + 1;
+        static_assert(EVENT_NOTIFIER, "arm() requires eventNotifier enabled in Traits");
+        static_assert(!OVERWRITE, "overwrite buffers are read with take()");
+        notifier.clear();
+        notifier.armed.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
 
-        if (capacity == readId + 1)
+        if (committed(readIndex(magicId), magicId))
         {
-            newRead = (magicId & WRAP_COUNT_MASK) + WRAP_COUNT_INCR;
+            notifier.armed.store(false, std::memory_order_relaxed);
+            return false;
         }
-        magicId = newRead;
-        reinterpret_cast<Bucket*>((static_cast<char*>(dataPtr) - OFFSET_TO_USED))->used.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    bool advanceWriteHead(std::uint64_t& currentWriteHead, const std::uint64_t newWriteHead)
+    {
+        if constexpr (SINGLE_PRODUCER)
+        {
+            writeHead.store(newWriteHead, std::memory_order_relaxed);
+            return true;
+        }
+        else
+        {
+            return writeHead.compare_exchange_strong(currentWriteHead, newWriteHead, std::memory_order_relaxed, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t takeTickets(const std::uint32_t count)
+    {
+        if constexpr (SINGLE_PRODUCER)
+        {
+            const std::uint64_t ticket = writeHead.load(std::memory_order_relaxed);
+            writeHead.store(ticket + count, std::memory_order_relaxed);
+            return ticket;
+        }
+        else
+        {
+            return writeHead.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+
+    void commitBucket(void* const dataPtr)
+    {
+        if constexpr (SEQUENCE)
+        {
+            Flag& sequence = data.flag(dataPtr);
+            sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+        else
+        {
+            data.flag(dataPtr).store(true, std::memory_order_release);
+        }
+    }
+
+    void notifyConsumer()
+    {
+        if constexpr (PARKING)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (parking.consumerParked.load(std::memory_order_relaxed))
+            {
+                wake();
+            }
+        }
+
+        if constexpr (EVENT_NOTIFIER)
+        {
+            // only the first commit after arm() signals the eventfd
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (notifier.armed.load(std::memory_order_relaxed) && notifier.armed.exchange(false, std::memory_order_relaxed))
+            {
+                notifier.signal();
+            }
+        }
+    }
+
+    void publishReadHead(const std::uint64_t newRead)
+    {
         readHead.store(newRead, std::memory_order_release);
+        notifyProducers();
+    }
+
+    void notifyProducers()
+    {
+        if constexpr (PARKING)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (parking.producersParked.load(std::memory_order_relaxed))
+            {
+                readHead.notify_all();
+            }
+        }
+    }
+
+    void prefetchAhead(const std::uint64_t magicId)
+    {
+        if constexpr (0 != PREFETCH_DISTANCE)
+        {
+            std::uint32_t id = readIndex(magicId) + PREFETCH_DISTANCE;
+            if (id >= capacity())
+            {
+                id %= capacity();
+            }
+            __builtin_prefetch(&data.flag(id), 0, 3);
+            __builtin_prefetch(data.payload(id), 0, 3);
+        }
+    }
+
+    void prefetchBucket(const std::uint32_t id, const std::uint32_t dataSize)
+    {
+        if constexpr (0 != PREFETCH_DISTANCE)
+        {
+            brb::prefetchForWrite(&data.flag(id));
+            for (std::uint32_t offset = 0; offset < dataSize && offset < maxDataSize; offset += std::hardware_destructive_interference_size)
+            {
+                brb::prefetchForWrite(data.payload(id) + offset);
+            }
+        }
+    }
+
+    void wait(Backoff& backoff, const void* const address)
+    {
+        const std::uint32_t spins = backoff.wait(address);
+        if constexpr (STATISTICS)
+        {
+            counters.pauseSpins(spins);
+        }
+    }
+
+    void countCasFailure()
+    {
+        if constexpr (STATISTICS)
+        {
+            counters.casFailure();
+        }
+    }
+
+    void countFullRejection()
+    {
+        if constexpr (STATISTICS)
+        {
+            counters.fullRejection();
+        }
+    }
+
+    void countEmptyPeek()
+    {
+        if constexpr (STATISTICS)
+        {
+            counters.emptyPeek();
+        }
+    }
+
+    void countOccupancy(const std::uint64_t write, const std::uint64_t read)
+    {
+        if constexpr (STATISTICS)
+        {
+            const std::uint64_t used = usedCount(write, read);
+            counters.occupancy(used < capacity() ? used : capacity());
+        }
+    }
+
+    template<typename Function>
+    void* spinThenYield(Function tryOnce, const void* const address)
+    {
+        Backoff backoff;
+        for (std::uint32_t i = 0; i < Traits::waitSpins; ++i)
+        {
+            if (void* dataPtr = tryOnce())
+            {
+                return dataPtr;
+            }
+            wait(backoff, address);
+        }
+
+        for (std::uint32_t i = 0; i < Traits::waitYields; ++i)
+        {
+            if (void* dataPtr = tryOnce())
+            {
+                return dataPtr;
+            }
+            std::this_thread::yield();
+        }
+        return tryOnce();
+    }
+
+    void initSequences()
+    {
+        if constexpr (SEQUENCE && !OVERWRITE)
+        {
+            for (std::uint32_t i = 0; i < capacity(); ++i)
+            {
+                data.flag(i).store(i, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::uint64_t usedCount(const std::uint64_t write, const std::uint64_t read)
+    {
+        if constexpr (MONOTONIC)
+        {
+            return write - read;
+        }
+        else
+        {
+            const std::uint32_t wrapCount = (write >> 32) - (read >> 32);
+            return static_cast<std::uint64_t>(wrapCount) * capacity() + (write & INDEX_MASK) - (read & INDEX_MASK);
+        }
+    }
+
+    std::uint32_t writeIndex(std::uint64_t& newWriteHead)
+    {
+        if constexpr (MONOTONIC)
+        {
+            return data.bucketIndex(newWriteHead);
+        }
+        else
+        {
+            const std::uint32_t freeId = newWriteHead & INDEX_MASK;
+            if (capacity() == freeId)
+            {
+                newWriteHead = (newWriteHead & WRAP_COUNT_MASK) + WRAP_COUNT_INCR;
+                return 0;
+            }
+            return freeId;
+        }
+    }
+
+    std::uint32_t bucketId(void* const dataPtr)
+    {
+        return (static_cast<char*>(dataPtr) - static_cast<char*>(data.begin()) - Storage::OFFSET_TO_PAYLOAD) / Storage::STRIDE;
+    }
+
+    std::uint32_t readIndex(const std::uint64_t magicId)
+    {
+        if constexpr (MONOTONIC)
+        {
+            return data.bucketIndex(magicId);
+        }
+        else
+        {
+            return magicId & INDEX_MASK;
+        }
+    }
+
+    bool committed(const std::uint32_t id, const std::uint64_t magicId)
+    {
+        if constexpr (SEQUENCE)
+        {
+            return data.flag(id).load(std::memory_order_acquire) == magicId + 1;
+        }
+        else
+        {
+            return data.flag(id).load(std::memory_order_acquire);
+        }
+    }
+
+    void waitForSequence(Flag& sequence, const std::uint64_t ticket)
+    {
+        Backoff backoff;
+        while (sequence.load(std::memory_order_acquire) != ticket)
+        {
+            wait(backoff, &sequence);
+        }
+    }
+
+    void fillSpan(Span& span, const std::uint32_t id, const std::uint32_t dataSize)
+    {
+        span.first = data.payload(id);
+        if (id + bucketsForRecord(dataSize) <= capacity())
+        {
+            span.firstSize = dataSize;
+            span.second = nullptr;
+            span.secondSize = 0;
+        }
+        else
+        {
+            span.firstSize = (capacity() - id) * Storage::STRIDE - Storage::OFFSET_TO_PAYLOAD;
+            span.second = data.begin();
+            span.secondSize = dataSize - span.firstSize;
+        }
     }
 };
 
@@ -0,0 +1,80 @@
+/* 
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __BRINGBUFFERAWAIT_HPP
+#define __BRINGBUFFERAWAIT_HPP
+
+#include "BRingBuffer.hpp"
+#include <coroutine>
+
+// Reactor is the event loop, watch(fd, handle) must resume handle once fd becomes readable
+template<typename Buffer, typename Reactor>
+class BPeekAwaitable
+{
+private:
+    Buffer& buffer;
+    Reactor& reactor;
+    std::uint32_t& dataSize;
+    const std::uint64_t magicId;
+    void* dataPtr = nullptr;
+
+public:
+    BPeekAwaitable(Buffer& buffer, Reactor& reactor, std::uint32_t& dataSize, const std::uint64_t magicId)
+        : buffer(buffer), reactor(reactor), dataSize(dataSize), magicId(magicId)
+    {
+    }
+
+    bool await_ready()
+    {
+        dataPtr = buffer.peek(dataSize, magicId);
+        return nullptr != dataPtr;
+    }
+
+    bool await_suspend(const std::coroutine_handle<> handle)
+    {
+        if (!buffer.arm(magicId))
+        {
+            return false;
+        }
+        reactor.watch(buffer.eventDescriptor(), handle);
+        return true;
+    }
+
+    void* await_resume()
+    {
+        return dataPtr ? dataPtr : buffer.peek(dataSize, magicId);
+    }
+};
+
+template<typename Buffer, typename Reactor>
+BPeekAwaitable<Buffer, Reactor> asyncPeek(Buffer& buffer, Reactor& reactor, std::uint32_t& dataSize, const std::uint64_t magicId)
+{
+    return BPeekAwaitable<Buffer, Reactor>(buffer, reactor, dataSize, magicId);
+}
+
+#endif
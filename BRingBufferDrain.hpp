@@ -0,0 +1,233 @@
+/* 
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __BRINGBUFFERDRAIN_HPP
+#define __BRINGBUFFERDRAIN_HPP
+
+#include "BRingBuffer.hpp"
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+template<typename Buffer, std::uint32_t maxBatch = 64>
+class BWritevDrain
+{
+private:
+    static_assert(maxBatch > 0 && maxBatch <= IOV_MAX, "maxBatch must not exceed IOV_MAX");
+
+    Buffer& buffer;
+    std::uint32_t offset = 0;
+    void* dataPtrs[maxBatch];
+    std::uint32_t dataSizes[maxBatch];
+    iovec vectors[maxBatch];
+
+public:
+    explicit BWritevDrain(Buffer& buffer)
+        : buffer(buffer)
+    {
+    }
+
+    ssize_t drain(const int fd, std::uint64_t& magicId)
+    {
+        const std::uint32_t count = buffer.peekBatch(dataPtrs, dataSizes, maxBatch, magicId);
+        if (0 == count)
+        {
+            return 0;
+        }
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            vectors[i].iov_base = dataPtrs[i];
+            vectors[i].iov_len = dataSizes[i];
+        }
+        // the first bucket may have been written partially by the previous call
+        vectors[0].iov_base = static_cast<char*>(vectors[0].iov_base) + offset;
+        vectors[0].iov_len -= offset;
+
+        const ssize_t written = writev(fd, vectors, count);
+        if (written < 0)
+        {
+            return written;
+        }
+
+        std::size_t left = written;
+        std::uint32_t done = 0;
+        while (done < count && left >= vectors[done].iov_len)
+        {
+            left -= vectors[done].iov_len;
+            ++done;
+        }
+
+        if (done == count)
+        {
+            offset = 0;
+        }
+        else
+        {
+            offset = 0 == done ? offset + left : left;
+        }
+        buffer.decommitBatch(done, magicId);
+        return written;
+    }
+};
+
+template<typename Buffer, std::uint32_t maxBatch = 64>
+class BSendmmsgDrain
+{
+private:
+    static_assert(maxBatch > 0 && maxBatch <= IOV_MAX, "maxBatch must not exceed IOV_MAX");
+
+    // limits of a single UDP_SEGMENT send, see UDP_MAX_SEGMENTS in the kernel
+    static constexpr std::uint32_t MAX_SEGMENTS = 64;
+    static constexpr std::uint32_t MAX_SEGMENTED_SIZE = 65507;
+
+    Buffer& buffer;
+    sockaddr_storage destination{};
+    socklen_t destinationSize = 0;
+    bool segmentation = false;
+    void* dataPtrs[maxBatch];
+    std::uint32_t dataSizes[maxBatch];
+    iovec vectors[maxBatch];
+    mmsghdr messages[maxBatch];
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(std::uint16_t))];
+
+    int sendSegmented(const int fd, const std::uint32_t count)
+    {
+        const std::uint32_t segmentSize = dataSizes[0];
+        std::uint32_t total = segmentSize;
+        std::uint32_t segments = 1;
+        // all datagrams but the last one of a GSO send must have the same size
+        while (segments < count && segments < MAX_SEGMENTS && dataSizes[segments] <= segmentSize &&
+               total + dataSizes[segments] <= MAX_SEGMENTED_SIZE)
+        {
+            total += dataSizes[segments];
+            if (dataSizes[segments++] < segmentSize)
+            {
+                break;
+            }
+        }
+        if (segments < 2)
+        {
+            return 0;
+        }
+
+        msghdr message{};
+        message.msg_name = destinationSize ? &destination : nullptr;
+        message.msg_namelen = destinationSize;
+        message.msg_iov = vectors;
+        message.msg_iovlen = segments;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_UDP;
+        header->cmsg_type = UDP_SEGMENT;
+        header->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+        const std::uint16_t size = segmentSize;
+        std::memcpy(CMSG_DATA(header), &size, sizeof(size));
+
+        if (sendmsg(fd, &message, 0) < 0)
+        {
+            // the socket or the device can not segment, fall back to sendmmsg()
+            if (EIO == errno || EINVAL == errno || ENOPROTOOPT == errno)
+            {
+                segmentation = false;
+                return 0;
+            }
+            return -1;
+        }
+        return segments;
+    }
+
+public:
+    explicit BSendmmsgDrain(Buffer& buffer, const sockaddr* destination = nullptr, const socklen_t destinationSize = 0)
+        : buffer(buffer)
+    {
+        if (destination && destinationSize <= sizeof(this->destination))
+        {
+            std::memcpy(&this->destination, destination, destinationSize);
+            this->destinationSize = destinationSize;
+        }
+    }
+
+    bool enableSegmentation(const int fd)
+    {
+        int size = 0;
+        socklen_t length = sizeof(size);
+        segmentation = 0 == getsockopt(fd, SOL_UDP, UDP_SEGMENT, &size, &length);
+        return segmentation;
+    }
+
+    int drain(const int fd, std::uint64_t& magicId)
+    {
+        const std::uint32_t count = buffer.peekBatch(dataPtrs, dataSizes, maxBatch, magicId);
+        if (0 == count)
+        {
+            return 0;
+        }
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            vectors[i].iov_base = dataPtrs[i];
+            vectors[i].iov_len = dataSizes[i];
+        }
+
+        int sent = 0;
+        if (segmentation && dataSizes[0] > 0)
+        {
+            sent = sendSegmented(fd, count);
+        }
+        if (0 == sent)
+        {
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                messages[i].msg_hdr = msghdr{};
+                messages[i].msg_hdr.msg_name = destinationSize ? &destination : nullptr;
+                messages[i].msg_hdr.msg_namelen = destinationSize;
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            sent = sendmmsg(fd, messages, count, 0);
+        }
+        if (sent < 0)
+        {
+            return sent;
+        }
+
+        buffer.decommitBatch(sent, magicId);
+        return sent;
+    }
+};
+
+#endif
@@ -0,0 +1,181 @@
+/* 
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __BSHARDEDRINGBUFFER_HPP
+#define __BSHARDEDRINGBUFFER_HPP
+
+#include "BRingBuffer.hpp"
+#include <utility>
+#include <vector>
+
+namespace brb
+{
+    template<typename Traits>
+    struct SingleProducerTraits : Traits
+    {
+        static constexpr bool singleProducer = true;
+    };
+
+    inline std::atomic<std::uint64_t> instanceCounter{ 0 };
+}
+
+template<std::uint32_t laneCount, std::uint32_t capacity, std::uint32_t maxDataSize, typename Traits = BRingBufferTraits>
+class BShardedRingBuffer
+{
+private:
+    using Lane = BRingBuffer<capacity, maxDataSize, brb::SingleProducerTraits<Traits>>;
+
+    const std::uint64_t instanceId = brb::instanceCounter.fetch_add(1, std::memory_order_relaxed);
+    alignas (std::hardware_destructive_interference_size) std::atomic<std::uint32_t> registeredLanes{ 0 };
+    alignas (std::hardware_destructive_interference_size) std::uint32_t currentLane = 0;
+    std::uint64_t magicIds[laneCount] = { 0 };
+    Lane lanes[laneCount];
+
+    Lane* lane()
+    {
+        thread_local std::vector<std::pair<std::uint64_t, std::uint32_t>> registry;
+        for (const auto& entry : registry)
+        {
+            if (entry.first == instanceId)
+            {
+                return &lanes[entry.second];
+            }
+        }
+
+        // bounded so that threads retrying without a lane never wrap the counter and share a lane
+        std::uint32_t laneId = registeredLanes.load(std::memory_order_relaxed);
+        do
+        {
+            if (laneId >= laneCount)
+            {
+                return nullptr;
+            }
+        }
+        while (!registeredLanes.compare_exchange_weak(laneId, laneId + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+        registry.emplace_back(instanceId, laneId);
+        return &lanes[laneId];
+    }
+
+    std::uint32_t laneOf(const void* const dataPtr) const
+    {
+        return (static_cast<const char*>(dataPtr) - reinterpret_cast<const char*>(lanes)) / sizeof(Lane);
+    }
+
+    std::uint32_t activeLanes() const
+    {
+        const std::uint32_t count = registeredLanes.load(std::memory_order_acquire);
+        return count < laneCount ? count : laneCount;
+    }
+
+public:
+    void* reserve(const std::uint32_t dataSize)
+    {
+        Lane* const producerLane = lane();
+        return producerLane ? producerLane->reserve(dataSize) : nullptr;
+    }
+
+    void commit(void* const dataPtr)
+    {
+        lanes[laneOf(dataPtr)].commit(dataPtr);
+    }
+
+    std::uint32_t reserveBatch(void** const dataPtrs, const std::uint32_t count, const std::uint32_t dataSize)
+    {
+        Lane* const producerLane = lane();
+        return producerLane ? producerLane->reserveBatch(dataPtrs, count, dataSize) : 0;
+    }
+
+    void commitBatch(void* const* const dataPtrs, const std::uint32_t count)
+    {
+        if (count)
+        {
+            lanes[laneOf(dataPtrs[0])].commitBatch(dataPtrs, count);
+        }
+    }
+
+    void* peek(std::uint32_t& dataSize)
+    {
+        const std::uint32_t count = activeLanes();
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            const std::uint32_t laneId = (currentLane + i) % count;
+            if (void* dataPtr = lanes[laneId].peek(dataSize, magicIds[laneId]))
+            {
+                currentLane = laneId;
+                return dataPtr;
+            }
+        }
+        return nullptr;
+    }
+
+    void decommit(void* const dataPtr)
+    {
+        const std::uint32_t laneId = laneOf(dataPtr);
+        lanes[laneId].decommit(dataPtr, magicIds[laneId]);
+        currentLane = laneId + 1;
+    }
+
+    std::uint32_t peekBatch(void** const dataPtrs, std::uint32_t* const dataSizes, const std::uint32_t maxCount)
+    {
+        const std::uint32_t count = activeLanes();
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            const std::uint32_t laneId = (currentLane + i) % count;
+            if (std::uint32_t peeked = lanes[laneId].peekBatch(dataPtrs, dataSizes, maxCount, magicIds[laneId]))
+            {
+                currentLane = laneId;
+                return peeked;
+            }
+        }
+        return 0;
+    }
+
+    void decommitBatch(const std::uint32_t count)
+    {
+        if (0 == count)
+        {
+            return;
+        }
+
+        lanes[currentLane].decommitBatch(count, magicIds[currentLane]);
+        ++currentLane;
+    }
+
+    brb::Statistics statistics() const
+    {
+        brb::Statistics statistics;
+        for (const Lane& lane : lanes)
+        {
+            statistics += lane.statistics();
+        }
+        return statistics;
+    }
+};
+
+#endif
@@ -0,0 +1,246 @@
+/* 
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __BSHAREDRINGBUFFER_HPP
+#define __BSHAREDRINGBUFFER_HPP
+
+#include "BRingBuffer.hpp"
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace brb
+{
+    enum class Open
+    {
+        Create,
+        Attach
+    };
+
+    struct SharedHeader
+    {
+        static constexpr std::uint64_t MAGIC = 0x4252494E47425546;
+        static constexpr std::uint32_t VERSION = 1;
+
+        std::atomic<std::uint64_t> magic{ 0 };
+        std::uint32_t version = 0;
+        std::uint32_t capacity = 0;
+        std::uint32_t maxDataSize = 0;
+        std::uint32_t layout = 0;
+        std::uint32_t engine = 0;
+        std::uint32_t flags = 0;
+        std::uint64_t regionSize = 0;
+    };
+}
+
+template<std::uint32_t capacity, std::uint32_t maxDataSize, typename Traits = BRingBufferTraits>
+class BSharedRingBuffer
+{
+public:
+    using Buffer = BRingBuffer<capacity, maxDataSize, Traits>;
+
+private:
+    static_assert(brb::DYNAMIC != capacity, "shared buffer requires the capacity given by the template parameter");
+    static_assert(!Traits::parking, "std::atomic::wait() is private to the process");
+    static_assert(!Traits::eventNotifier, "the eventfd is private to the process");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<bool>::is_always_lock_free, "shared buffer requires lock free atomics");
+    static_assert(std::is_standard_layout_v<brb::SharedHeader>);
+
+    struct Region
+    {
+        alignas (std::hardware_destructive_interference_size) brb::SharedHeader header;
+        Buffer buffer;
+    };
+
+    // options which change how the processes interpret the shared region, in addition to those that change its size
+    static constexpr std::uint32_t FLAGS = (Traits::cacheReadHead ? 1 : 0) | (Traits::singleProducer ? 2 : 0) | (Traits::timestamps ? 4 : 0) |
+        (Traits::overwrite ? 8 : 0) | (Traits::statistics ? 16 : 0) | (Traits::reorderWindow << 8);
+
+    std::string name;
+    int fd = -1;
+    Region* region = nullptr;
+
+    void map()
+    {
+        void* ptr = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == ptr)
+        {
+            fail("mmap() failed");
+        }
+        region = static_cast<Region*>(ptr);
+    }
+
+    void create()
+    {
+        if (0 != ftruncate(fd, sizeof(Region)))
+        {
+            fail("ftruncate() failed");
+        }
+        map();
+
+        new (region) Region();
+        brb::SharedHeader& header = region->header;
+        header.version = brb::SharedHeader::VERSION;
+        header.capacity = capacity;
+        header.maxDataSize = maxDataSize;
+        header.layout = static_cast<std::uint32_t>(Traits::layout);
+        header.engine = static_cast<std::uint32_t>(Traits::engine);
+        header.flags = FLAGS;
+        header.regionSize = sizeof(Region);
+        header.magic.store(brb::SharedHeader::MAGIC, std::memory_order_release);
+    }
+
+    void attach()
+    {
+        struct stat status;
+        if (0 != fstat(fd, &status))
+        {
+            fail("fstat() failed");
+        }
+        if (static_cast<std::uint64_t>(status.st_size) != sizeof(Region))
+        {
+            release();
+            throw std::runtime_error("shared buffer size mismatch");
+        }
+        map();
+
+        const brb::SharedHeader& header = region->header;
+        if (brb::SharedHeader::MAGIC != header.magic.load(std::memory_order_acquire) || brb::SharedHeader::VERSION != header.version)
+        {
+            release();
+            throw std::runtime_error("shared buffer not initialized or version mismatch");
+        }
+        if (capacity != header.capacity || maxDataSize != header.maxDataSize || static_cast<std::uint32_t>(Traits::layout) != header.layout ||
+            static_cast<std::uint32_t>(Traits::engine) != header.engine || FLAGS != header.flags || sizeof(Region) != header.regionSize)
+        {
+            release();
+            throw std::runtime_error("shared buffer configuration mismatch");
+        }
+    }
+
+    void release()
+    {
+        if (region)
+        {
+            munmap(region, sizeof(Region));
+            region = nullptr;
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    [[noreturn]] void fail(const char* what)
+    {
+        const int error = errno;
+        release();
+        if (!name.empty())
+        {
+            shm_unlink(name.c_str());
+        }
+        throw std::system_error(error, std::generic_category(), what);
+    }
+
+public:
+    BSharedRingBuffer()
+    {
+        fd = memfd_create("BSharedRingBuffer", MFD_CLOEXEC);
+        if (fd < 0)
+        {
+            fail("memfd_create() failed");
+        }
+        create();
+    }
+
+    explicit BSharedRingBuffer(const int sharedFd)
+    {
+        fd = dup(sharedFd);
+        if (fd < 0)
+        {
+            fail("dup() failed");
+        }
+        attach();
+    }
+
+    BSharedRingBuffer(const char* const shmName, const brb::Open open)
+    {
+        if (brb::Open::Create == open)
+        {
+            fd = shm_open(shmName, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+            if (fd < 0)
+            {
+                fail("shm_open() failed");
+            }
+            name = shmName;
+            create();
+        }
+        else
+        {
+            fd = shm_open(shmName, O_RDWR, 0);
+            if (fd < 0)
+            {
+                fail("shm_open() failed");
+            }
+            attach();
+        }
+    }
+
+    ~BSharedRingBuffer()
+    {
+        release();
+        if (!name.empty())
+        {
+            shm_unlink(name.c_str());
+        }
+    }
+
+    BSharedRingBuffer(const BSharedRingBuffer&) = delete;
+    BSharedRingBuffer& operator=(const BSharedRingBuffer&) = delete;
+
+    int descriptor() const
+    {
+        return fd;
+    }
+
+    Buffer& buffer()
+    {
+        return region->buffer;
+    }
+
+    Buffer* operator->()
+    {
+        return &region->buffer;
+    }
+};
+
+#endif
@@ -0,0 +1,252 @@
+/* 
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __BTYPEDRINGBUFFER_HPP
+#define __BTYPEDRINGBUFFER_HPP
+
+#include "BRingBuffer.hpp"
+#include <utility>
+
+template<typename T, std::uint32_t capacity, std::uint32_t maxDataSize = sizeof(T), typename Traits = BRingBufferTraits>
+class BTypedRingBuffer
+{
+public:
+    using Buffer = BRingBuffer<capacity, maxDataSize, Traits>;
+
+private:
+    static_assert(sizeof(T) <= maxDataSize, "T does not fit into a bucket");
+    static_assert(0 == Buffer::PAYLOAD_ALIGNMENT % alignof(T), "buckets are not aligned enough for T");
+
+    Buffer buffer;
+    alignas (std::hardware_destructive_interference_size) std::uint64_t magicId = 0;
+
+public:
+    class Reservation
+    {
+    private:
+        Buffer* buffer = nullptr;
+        void* dataPtr = nullptr;
+        bool constructed = false;
+
+        friend class BTypedRingBuffer;
+
+        Reservation(Buffer* const buffer, void* const dataPtr)
+            : buffer(buffer), dataPtr(dataPtr)
+        {
+        }
+
+    public:
+        Reservation() = default;
+
+        Reservation(Reservation&& other) noexcept
+            : buffer(other.buffer), dataPtr(std::exchange(other.dataPtr, nullptr)), constructed(other.constructed)
+        {
+        }
+
+        Reservation& operator=(Reservation&& other) noexcept
+        {
+            if (this != &other)
+            {
+                commit();
+                buffer = other.buffer;
+                dataPtr = std::exchange(other.dataPtr, nullptr);
+                constructed = other.constructed;
+            }
+            return *this;
+        }
+
+        ~Reservation()
+        {
+            commit();
+        }
+
+        explicit operator bool() const
+        {
+            return nullptr != dataPtr;
+        }
+
+        template<typename... Args>
+        T& emplace(Args&&... args)
+        {
+            if (constructed)
+            {
+                get()->~T();
+                constructed = false;
+            }
+            T* const object = new (dataPtr) T(std::forward<Args>(args)...);
+            constructed = true;
+            return *object;
+        }
+
+        T* get() const
+        {
+            return constructed ? std::launder(static_cast<T*>(dataPtr)) : nullptr;
+        }
+
+        T& operator*() const
+        {
+            return *get();
+        }
+
+        T* operator->() const
+        {
+            return get();
+        }
+
+        void commit()
+        {
+            if (dataPtr)
+            {
+                // an empty bucket is committed as well, the consumer would wait for it forever otherwise
+                buffer->commit(std::exchange(dataPtr, nullptr), constructed ? sizeof(T) : 0);
+            }
+        }
+    };
+
+    class View
+    {
+    private:
+        Buffer* buffer = nullptr;
+        std::uint64_t* magicId = nullptr;
+        T* object = nullptr;
+
+        friend class BTypedRingBuffer;
+
+        View(Buffer* const buffer, std::uint64_t* const magicId, void* const dataPtr)
+            : buffer(buffer), magicId(magicId), object(std::launder(static_cast<T*>(dataPtr)))
+        {
+        }
+
+    public:
+        View() = default;
+
+        View(View&& other) noexcept
+            : buffer(other.buffer), magicId(other.magicId), object(std::exchange(other.object, nullptr))
+        {
+        }
+
+        View& operator=(View&& other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                buffer = other.buffer;
+                magicId = other.magicId;
+                object = std::exchange(other.object, nullptr);
+            }
+            return *this;
+        }
+
+        ~View()
+        {
+            release();
+        }
+
+        explicit operator bool() const
+        {
+            return nullptr != object;
+        }
+
+        T* get() const
+        {
+            return object;
+        }
+
+        T& operator*() const
+        {
+            return *object;
+        }
+
+        T* operator->() const
+        {
+            return object;
+        }
+
+        void release()
+        {
+            if (object)
+            {
+                object->~T();
+                buffer->decommit(std::exchange(object, nullptr), *magicId);
+            }
+        }
+    };
+
+    BTypedRingBuffer() = default;
+
+    template<typename... Args>
+    explicit BTypedRingBuffer(Args&&... args)
+        : buffer(std::forward<Args>(args)...)
+    {
+    }
+
+    ~BTypedRingBuffer()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            while (peek())
+            {
+            }
+        }
+    }
+
+    BTypedRingBuffer(const BTypedRingBuffer&) = delete;
+    BTypedRingBuffer& operator=(const BTypedRingBuffer&) = delete;
+
+    Reservation reserve()
+    {
+        return Reservation(&buffer, buffer.reserve(sizeof(T)));
+    }
+
+    template<typename... Args>
+    bool try_emplace(Args&&... args)
+    {
+        Reservation reservation = reserve();
+        if (!reservation)
+        {
+            return false;
+        }
+        reservation.emplace(std::forward<Args>(args)...);
+        return true;
+    }
+
+    View peek()
+    {
+        std::uint32_t dataSize;
+        void* dataPtr = buffer.peek(dataSize, magicId);
+        while (dataPtr && 0 == dataSize)
+        {
+            buffer.decommit(dataPtr, magicId);
+            dataPtr = buffer.peek(dataSize, magicId);
+        }
+        return dataPtr ? View(&buffer, &magicId, dataPtr) : View();
+    }
+};
+
+#endif
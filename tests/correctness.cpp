@@ -0,0 +1,148 @@
+/*
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "BPriorityRingBuffer.hpp"
+#include <iostream>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct OverwriteTraits : BRingBufferTraits
+{
+    static constexpr brb::Engine engine = brb::Engine::Sequence;
+    static constexpr bool overwrite = true;
+};
+
+static bool push(BPriorityRingBuffer<3, 16, sizeof(std::uint32_t)>& buffer, const std::uint32_t priority, const std::uint32_t value)
+{
+    void* data = buffer.reserve(priority, sizeof(value));
+    if (nullptr == data)
+    {
+        return false;
+    }
+    memcpy(data, &value, sizeof(value));
+    buffer.commit(data);
+    return true;
+}
+
+// a starvation turn of an empty lane must not let a lower lane overtake lane 0
+static bool testStarvedLaneEmpty()
+{
+    BPriorityRingBuffer<3, 16, sizeof(std::uint32_t)> buffer(2);
+    for (std::uint32_t i = 0; i < 3; ++i)
+    {
+        push(buffer, 0, i);
+    }
+    push(buffer, 2, 200);
+
+    const std::uint32_t expected[] = { 0, 1, 2, 200 };
+    for (const std::uint32_t value : expected)
+    {
+        std::uint32_t size;
+        void* data = buffer.peek(size);
+        if (nullptr == data)
+        {
+            return false;
+        }
+        std::uint32_t peeked;
+        memcpy(&peeked, data, sizeof(peeked));
+        buffer.decommit(data);
+        if (peeked != value)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// every message is either taken or counted as lost, the tickets of lapped producers are not
+static bool testOverwriteLostCount()
+{
+    constexpr std::uint32_t PRODUCERS = 4;
+    constexpr std::uint64_t MESSAGES = 200000;
+    using Buffer = BRingBuffer<64, sizeof(std::uint64_t), OverwriteTraits>;
+    Buffer* buffer = new Buffer();
+    std::atomic<std::uint32_t> finished{ 0 };
+
+    std::vector<std::thread> producers;
+    for (std::uint32_t i = 0; i < PRODUCERS; ++i)
+    {
+        producers.emplace_back([buffer, &finished]
+        {
+            for (std::uint64_t message = 0; message < MESSAGES; ++message)
+            {
+                void* data = buffer->reserve(sizeof(message));
+                memcpy(data, &message, sizeof(message));
+                buffer->commit(data);
+            }
+            finished.fetch_add(1);
+        });
+    }
+
+    std::uint64_t magicId = 0;
+    std::uint64_t taken = 0;
+    std::uint64_t lost = 0;
+    std::uint64_t payload;
+    std::uint32_t size;
+    while (true)
+    {
+        const bool done = PRODUCERS == finished.load();
+        if (buffer->take(&payload, size, magicId, lost))
+        {
+            ++taken;
+        }
+        else if (done)
+        {
+            break;
+        }
+    }
+
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    delete buffer;
+    return taken + lost == PRODUCERS * MESSAGES;
+}
+
+int main()
+{
+    bool passed = true;
+    const auto check = [&passed](const char* name, const bool result)
+    {
+        std::cout << name << (result ? " : ok\n" : " : failed!\n");
+        passed = passed && result;
+    };
+
+    check("priority starved lane empty", testStarvedLaneEmpty());
+    check("overwrite lost count", testOverwriteLostCount());
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,379 @@
+/*
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "BRingBuffer.hpp"
+#include "topology.hpp"
+#include <iostream>
+#include <latch>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include <sched.h>
+#include <string.h>
+
+constexpr std::uint32_t MAX_BACKOFF = 32;
+
+struct Options
+{
+    std::uint32_t repeats = 5;
+    std::chrono::milliseconds duration{ 200 };
+    std::vector<std::uint32_t> producers;
+    std::vector<std::uint32_t> cpus;
+    std::vector<std::string> placements;
+    std::string filter;
+    bool json = false;
+};
+
+struct Case
+{
+    std::string layout;
+    std::string engine;
+    std::uint32_t capacity;
+    std::uint32_t dataSize;
+    std::uint32_t prefetch;
+    std::function<std::uint64_t(const Options&, std::uint32_t)> run;
+};
+
+template<brb::Layout layoutValue, brb::Engine engineValue, std::uint32_t prefetchDistanceValue>
+struct BenchTraits : BRingBufferTraits
+{
+    static constexpr brb::Layout layout = layoutValue;
+    static constexpr brb::Engine engine = engineValue;
+    static constexpr std::uint32_t prefetchDistance = prefetchDistanceValue;
+};
+
+static void setThreadAffinity(const std::uint32_t cpuId)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpuId, &set);
+    if (0 != sched_setaffinity(0, sizeof(cpu_set_t), &set))
+    {
+       std::cerr << "failed to set affinity: " << strerror(errno) << ", cpuId: " << cpuId << "\n";
+       std::abort();
+    }
+}
+
+template<typename Buffer, std::uint32_t dataSize>
+static void producerThread(const std::uint32_t cpuId, std::latch& startSync, Buffer* buffer, const volatile bool& stop)
+{
+    setThreadAffinity(cpuId);
+    char payload[dataSize];
+    memset(payload, static_cast<int>(cpuId), dataSize);
+    brb::PauseBackoff<MAX_BACKOFF> backoff;
+    startSync.arrive_and_wait();
+    while (!stop)
+    {
+        void* data = buffer->reserve(dataSize);
+        if (data)
+        {
+            memcpy(data, payload, dataSize);
+            buffer->commit(data);
+            backoff = {};
+        }
+        else
+        {
+            backoff.wait(nullptr);
+        }
+    }
+}
+
+template<typename Buffer, std::uint32_t dataSize>
+static void consumerThread(const std::uint32_t cpuId, std::latch& startSync, Buffer* buffer, const volatile bool& stop, std::uint64_t& consumed)
+{
+    setThreadAffinity(cpuId);
+    char payload[dataSize];
+    std::uint64_t id = 0;
+    std::uint64_t count = 0;
+    startSync.arrive_and_wait();
+    std::uint32_t size;
+    while (!stop)
+    {
+        void* data = buffer->peek(size, id);
+        if (data)
+        {
+            memcpy(payload, data, size);
+            asm volatile("" : : "r" (payload) : "memory");
+            buffer->decommit(data, id);
+            ++count;
+        }
+        else
+        {
+            asm volatile("pause");
+        }
+    }
+    consumed = count;
+}
+
+template<typename Buffer, std::uint32_t dataSize>
+static std::uint64_t testThroughput(const Options& options, const std::uint32_t producersCount)
+{
+    Buffer* buffer = new Buffer();
+    volatile bool stopProducer = false;
+    volatile bool stopConsumer = false;
+    std::uint64_t consumed = 0;
+    std::latch startSync{ producersCount + 2 };
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(consumerThread<Buffer, dataSize>, options.cpus[0], std::ref(startSync), buffer, std::cref(stopConsumer), std::ref(consumed));
+    for (std::uint32_t i = 1; i <= producersCount; ++i)
+    {
+        threads.emplace_back(producerThread<Buffer, dataSize>, options.cpus[i % options.cpus.size()], std::ref(startSync), buffer, std::cref(stopProducer));
+    }
+
+    startSync.arrive_and_wait();
+    std::this_thread::sleep_for(options.duration);
+
+    stopProducer = true;
+    for (std::uint32_t i = 1; i <= producersCount; ++i)
+    {
+        threads[i].join();
+    }
+    stopConsumer = true;
+    threads[0].join();
+
+    delete buffer;
+    return consumed * 1000 / options.duration.count();
+}
+
+static const char* layoutName(const brb::Layout layout)
+{
+    return brb::Layout::Padded == layout ? "padded" : brb::Layout::Packed == layout ? "packed" : "split";
+}
+
+static const char* engineName(const brb::Engine engine)
+{
+    return brb::Engine::Cas == engine ? "cas" : "sequence";
+}
+
+template<brb::Layout layout, brb::Engine engine, std::uint32_t prefetch, std::uint32_t capacity, std::uint32_t... dataSizes>
+static void addCases(std::vector<Case>& cases)
+{
+    (cases.push_back({ layoutName(layout), engineName(engine), capacity, dataSizes, prefetch,
+        testThroughput<BRingBuffer<capacity, dataSizes, BenchTraits<layout, engine, prefetch>>, dataSizes> }), ...);
+}
+
+template<brb::Layout layout, brb::Engine engine, std::uint32_t prefetch = 0>
+static void addCapacities(std::vector<Case>& cases)
+{
+    addCases<layout, engine, prefetch, 256, 4, 64, 256, 1024>(cases);
+    addCases<layout, engine, prefetch, 300, 4, 64, 256, 1024>(cases);
+    addCases<layout, engine, prefetch, 4096, 4, 64, 256, 1024>(cases);
+}
+
+static std::vector<std::uint32_t> parseList(const char* arg)
+{
+    std::vector<std::uint32_t> list;
+    for (const char* ptr = arg; *ptr;)
+    {
+        char* end;
+        list.push_back(std::strtoul(ptr, &end, 10));
+        ptr = *end ? end + 1 : end;
+    }
+    return list;
+}
+
+static void usage(const char* name)
+{
+    std::cerr << "usage: " << name << " [--repeats N] [--duration MS] [--producers 1,2,4] [--cpus 0,2,4] [--placement smt,l3,cross-l3,cross-socket|all] [--filter padded-cas-256-] [--json]\n";
+    std::exit(1);
+}
+
+static Options parseOptions(const int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if ("--json" == arg)
+        {
+            options.json = true;
+        }
+        else if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+        }
+        else if ("--repeats" == arg)
+        {
+            options.repeats = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if ("--duration" == arg)
+        {
+            options.duration = std::chrono::milliseconds(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if ("--producers" == arg)
+        {
+            options.producers = parseList(argv[++i]);
+        }
+        else if ("--cpus" == arg)
+        {
+            options.cpus = parseList(argv[++i]);
+        }
+        else if ("--placement" == arg)
+        {
+            const std::string list = argv[++i];
+            for (std::size_t position = 0; position < list.size();)
+            {
+                const std::size_t end = std::min(list.find(',', position), list.size());
+                options.placements.push_back(list.substr(position, end - position));
+                position = end + 1;
+            }
+            if ("all" == list)
+            {
+                options.placements.assign(std::begin(PLACEMENTS), std::end(PLACEMENTS));
+            }
+        }
+        else if ("--filter" == arg)
+        {
+            options.filter = argv[++i];
+        }
+        else
+        {
+            usage(argv[0]);
+        }
+    }
+
+    if (options.cpus.empty())
+    {
+        for (std::uint32_t i = 0; i < std::thread::hardware_concurrency(); ++i)
+        {
+            options.cpus.push_back(i);
+        }
+    }
+    if (options.producers.empty())
+    {
+        for (std::uint32_t i = 1; i < options.cpus.size(); ++i)
+        {
+            options.producers.push_back(i);
+        }
+    }
+    if (0 == options.repeats || 0 == options.duration.count() || options.producers.empty())
+    {
+        usage(argv[0]);
+    }
+    return options;
+}
+
+int main(int argc, char** argv)
+{
+    const Options options = parseOptions(argc, argv);
+
+    std::vector<Case> cases;
+    addCapacities<brb::Layout::Padded, brb::Engine::Cas>(cases);
+    addCapacities<brb::Layout::Packed, brb::Engine::Cas>(cases);
+    addCapacities<brb::Layout::Split, brb::Engine::Cas>(cases);
+    addCapacities<brb::Layout::Padded, brb::Engine::Sequence>(cases);
+    addCapacities<brb::Layout::Packed, brb::Engine::Sequence>(cases);
+    addCapacities<brb::Layout::Split, brb::Engine::Sequence>(cases);
+    addCapacities<brb::Layout::Padded, brb::Engine::Cas, 4>(cases);
+    addCapacities<brb::Layout::Split, brb::Engine::Cas, 4>(cases);
+
+    if (options.json)
+    {
+        std::cout << "[";
+    }
+    else
+    {
+        std::cout << "layout,engine,capacity,payload,prefetch,producers,placement,repeats,mean,stddev,min,max\n";
+    }
+
+    const std::vector<Cpu> topology = readTopology();
+    const std::vector<std::string> placements = options.placements.empty() ? std::vector<std::string>{ "cpus" } : options.placements;
+
+    bool first = true;
+    for (const Case& benchCase : cases)
+    {
+        const std::string name = benchCase.layout + "-" + benchCase.engine + "-" + std::to_string(benchCase.capacity) + "-" + std::to_string(benchCase.dataSize) + "-" + std::to_string(benchCase.prefetch);
+        if (std::string::npos == (name + "-").find(options.filter))
+        {
+            continue;
+        }
+
+        for (const std::string& placement : placements)
+        {
+            for (const std::uint32_t producersCount : options.producers)
+            {
+                Options placed = options;
+                if (!options.placements.empty())
+                {
+                    placed.cpus = placeThreads(topology, placement, producersCount);
+                    if (placed.cpus.empty())
+                    {
+                        continue;
+                    }
+                }
+
+                std::vector<double> results;
+                for (std::uint32_t i = 0; i < options.repeats; ++i)
+                {
+                    results.push_back(benchCase.run(placed, producersCount));
+                }
+
+                double mean = 0, variance = 0, min = results[0], max = results[0];
+                for (const double result : results)
+                {
+                    mean += result / results.size();
+                    min = result < min ? result : min;
+                    max = result > max ? result : max;
+                }
+                for (const double result : results)
+                {
+                    variance += (result - mean) * (result - mean) / results.size();
+                }
+                const double stddev = std::sqrt(variance);
+
+                if (options.json)
+                {
+                    std::cout << (first ? "" : ",") << "\n  {\"layout\": \"" << benchCase.layout << "\", \"engine\": \"" << benchCase.engine
+                        << "\", \"capacity\": " << benchCase.capacity << ", \"payload\": " << benchCase.dataSize << ", \"prefetch\": " << benchCase.prefetch << ", \"producers\": " << producersCount << ", \"placement\": \"" << placement << "\""
+                        << ", \"repeats\": " << options.repeats << ", \"mean\": " << static_cast<std::uint64_t>(mean) << ", \"stddev\": " << static_cast<std::uint64_t>(stddev)
+                        << ", \"min\": " << static_cast<std::uint64_t>(min) << ", \"max\": " << static_cast<std::uint64_t>(max) << "}";
+                }
+                else
+                {
+                    std::cout << benchCase.layout << "," << benchCase.engine << "," << benchCase.capacity << "," << benchCase.dataSize << "," << benchCase.prefetch << "," << producersCount << "," << placement
+                        << "," << options.repeats << "," << static_cast<std::uint64_t>(mean) << "," << static_cast<std::uint64_t>(stddev)
+                        << "," << static_cast<std::uint64_t>(min) << "," << static_cast<std::uint64_t>(max) << std::endl;
+                }
+                first = false;
+            }
+        }
+    }
+
+    if (options.json)
+    {
+        std::cout << "\n]\n";
+    }
+    return 0;
+}
@@ -28,6 +28,7 @@
  */
 
 #include "BRingBuffer.hpp"
+#include "topology.hpp"
 #include <iostream>
 #include <latch>
 #include <thread>
@@ -45,12 +46,43 @@
 
 constexpr std::uint32_t MAX_DATA_SIZE = sizeof(std::uint32_t);
 constexpr std::uint32_t CAPACITY = 300;
+constexpr std::uint32_t POW2_CAPACITY = 256;
 constexpr std::uint32_t MAX_ELEMENTS = 5000;
 constexpr std::uint32_t MAX_BACKOFF = 32;
-BRingBuffer<CAPACITY, MAX_DATA_SIZE> buffer;
+constexpr std::uint32_t PREFETCH_DISTANCE = 4;
 
-std::vector<std::uint64_t> producerCycles;
-std::vector<std::uint64_t> consumerCycles;
+struct PackedTraits : BRingBufferTraits
+{
+    static constexpr brb::Layout layout = brb::Layout::Packed;
+};
+
+struct SplitTraits : BRingBufferTraits
+{
+    static constexpr brb::Layout layout = brb::Layout::Split;
+};
+
+struct CachedTraits : BRingBufferTraits
+{
+    static constexpr bool cacheReadHead = true;
+};
+
+struct PrefetchTraits : BRingBufferTraits
+{
+    static constexpr std::uint32_t prefetchDistance = PREFETCH_DISTANCE;
+};
+
+using PaddedBuffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE>;
+using PackedBuffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE, PackedTraits>;
+using SplitBuffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE, SplitTraits>;
+using CachedBuffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE, CachedTraits>;
+using Pow2Buffer = BRingBuffer<POW2_CAPACITY, MAX_DATA_SIZE>;
+using PrefetchBuffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE, PrefetchTraits>;
+
+struct Cycles
+{
+    std::vector<std::uint64_t> producer;
+    std::vector<std::uint64_t> consumer;
+};
 
 static void setThreadAffinity(const std::uint32_t cpuId)
 {
@@ -132,14 +164,13 @@ static EventData getEventPage(const std::uint32_t cpuId)
     return eventData;
 }
 
-std::latch startSync{ 2 };
-
-static void producerThread(const std::uint32_t cpuId)
+template<typename Buffer>
+static void producerThread(const std::uint32_t cpuId, std::latch& startSync, Buffer& buffer, std::vector<std::uint64_t>& producerCycles)
 {
     setThreadAffinity(cpuId);
     EventData eventData = getEventPage(cpuId);
     auto tid = gettid();
-    std::uint32_t backoffCount = 1;
+    brb::PauseBackoff<MAX_BACKOFF> backoff;
     ioctl(eventData.fd, PERF_EVENT_IOC_ENABLE, 0);
 
     startSync.arrive_and_wait();
@@ -156,22 +187,19 @@ static void producerThread(const std::uint32_t cpuId)
             auto end = getCycles(eventData.ptr);
             producerCycles.push_back(end - beg);
             ++i;
-            backoffCount = 1;
+            backoff = {};
         }
         else
         {
-            while (backoffCount--)
-            {
-                asm volatile("pause");
-            }
-            backoffCount = backoffCount < MAX_BACKOFF ? backoffCount << 1 : MAX_BACKOFF;
+            backoff.wait(nullptr);
         }
     }
     ioctl(eventData.fd, PERF_EVENT_IOC_DISABLE, 0);
     munmap(eventData.ptr, getpagesize());
 }
 
-static void consumerThread(const std::uint32_t cpuId)
+template<typename Buffer>
+static void consumerThread(const std::uint32_t cpuId, std::latch& startSync, Buffer& buffer, std::vector<std::uint64_t>& consumerCycles)
 {
     setThreadAffinity(cpuId);
     EventData eventData = getEventPage(cpuId);
@@ -237,27 +265,64 @@ void rdpmcTest()
     rdpmcOutput.close();
 }
 
-int main()
+template<typename Buffer>
+Cycles testCycles(const std::vector<std::uint32_t>& cpus)
 {
-    std::cout << "buffer size : " << sizeof(buffer) << " bytes\n";
-
-    producerCycles.reserve(MAX_ELEMENTS);
-    consumerCycles.reserve(MAX_ELEMENTS);
-
-    rdpmcTest();
+    Buffer* buffer = new Buffer();
+    std::latch startSync{ 2 };
+    Cycles cycles;
+    cycles.producer.reserve(MAX_ELEMENTS);
+    cycles.consumer.reserve(MAX_ELEMENTS);
 
     std::vector<std::thread> threads;
-    threads.emplace_back(consumerThread, 0);
-    threads.emplace_back(producerThread, 1);
+    threads.emplace_back(consumerThread<Buffer>, cpus[0], std::ref(startSync), std::ref(*buffer), std::ref(cycles.consumer));
+    threads.emplace_back(producerThread<Buffer>, cpus[1], std::ref(startSync), std::ref(*buffer), std::ref(cycles.producer));
 
     threads[1].join();
     threads[0].join();
 
-    std::ofstream outputCsv("cpu_cycles.csv");
-    outputCsv << "iteration;producerCycles;consumerCycle\n";
+    delete buffer;
+    return cycles;
+}
+
+int main(int argc, char** argv)
+{
+    // an optional placement of the producer relative to the consumer, cpus 0 and 1 otherwise
+    std::vector<std::uint32_t> cpus{ 0, 1 };
+    std::string outputName = "cpu_cycles.csv";
+    if (argc > 1)
+    {
+        cpus = placeThreads(readTopology(), argv[1], 1);
+        if (cpus.empty())
+        {
+            std::cout << "no cpus for placement " << argv[1] << ", placements: smt, l3, cross-l3, cross-socket\n";
+            return 1;
+        }
+        outputName = std::string("cpu_cycles-") + argv[1] + ".csv";
+        std::cout << "placement " << argv[1] << ": consumer on cpu " << cpus[0] << ", producer on cpu " << cpus[1] << "\n";
+    }
+
+    std::cout << "buffer size: padded " << sizeof(PaddedBuffer) << " bytes, packed " << sizeof(PackedBuffer) << " bytes, split " << sizeof(SplitBuffer) << " bytes\n";
+
+    rdpmcTest();
+
+    Cycles padded = testCycles<PaddedBuffer>(cpus);
+    Cycles packed = testCycles<PackedBuffer>(cpus);
+    Cycles split = testCycles<SplitBuffer>(cpus);
+    Cycles cached = testCycles<CachedBuffer>(cpus);
+    Cycles pow2 = testCycles<Pow2Buffer>(cpus);
+    Cycles prefetch = testCycles<PrefetchBuffer>(cpus);
+
+    std::ofstream outputCsv(outputName);
+    outputCsv << "iteration;producerCycles;consumerCycle;packedProducerCycles;packedConsumerCycles;splitProducerCycles;splitConsumerCycles;cachedProducerCycles;cachedConsumerCycles;pow2ProducerCycles;pow2ConsumerCycles;prefetchProducerCycles;prefetchConsumerCycles\n";
     for (std::uint32_t i = 0; i < MAX_ELEMENTS; ++i)
     {
-        outputCsv << i + 1 << ";" << producerCycles[i] << ";" << consumerCycles[i] << "\n";
+        outputCsv << i + 1 << ";" << padded.producer[i] << ";" << padded.consumer[i]
+            << ";" << packed.producer[i] << ";" << packed.consumer[i]
+            << ";" << split.producer[i] << ";" << split.consumer[i]
+            << ";" << cached.producer[i] << ";" << cached.consumer[i]
+            << ";" << pow2.producer[i] << ";" << pow2.consumer[i]
+            << ";" << prefetch.producer[i] << ";" << prefetch.consumer[i] << "\n";
     }
     outputCsv.close();
 
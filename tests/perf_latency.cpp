@@ -0,0 +1,267 @@
+/*
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "BRingBuffer.hpp"
+#include <iostream>
+#include <latch>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstring>
+
+#include <unistd.h>
+#include <sched.h>
+#include <string.h>
+#include <x86intrin.h>
+
+using namespace std::chrono_literals;
+
+constexpr std::uint32_t MAX_DATA_SIZE = sizeof(std::uint64_t);
+constexpr std::uint32_t CAPACITY = 300;
+constexpr std::uint32_t MAX_BACKOFF = 32;
+constexpr std::uint64_t RATES[] = { 100000, 1000000, 10000000, 0 };
+
+using Buffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE>;
+
+class Histogram
+{
+private:
+    static constexpr std::uint32_t SUB_BUCKET_BITS = 5;
+    static constexpr std::uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // values with the highest bit 63 take the indexes up to (64 - SUB_BUCKET_BITS) * SUB_BUCKETS + SUB_BUCKETS - 1
+    static constexpr std::uint32_t BUCKETS = (65 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    std::vector<std::uint64_t> counts = std::vector<std::uint64_t>(BUCKETS, 0);
+    std::uint64_t total = 0;
+    std::uint64_t max = 0;
+
+    static std::uint32_t index(const std::uint64_t value)
+    {
+        const std::uint32_t msb = 63 - __builtin_clzll(value | 1);
+        if (msb <= SUB_BUCKET_BITS)
+        {
+            return value;
+        }
+        const std::uint32_t shift = msb - SUB_BUCKET_BITS;
+        return (shift << SUB_BUCKET_BITS) + (value >> shift);
+    }
+
+    static std::uint64_t highestValue(const std::uint32_t id)
+    {
+        if (id < 2 * SUB_BUCKETS)
+        {
+            return id;
+        }
+        const std::uint32_t shift = id / SUB_BUCKETS - 1;
+        return ((static_cast<std::uint64_t>(id % SUB_BUCKETS + SUB_BUCKETS) + 1) << shift) - 1;
+    }
+
+public:
+    void record(const std::uint64_t value)
+    {
+        ++counts[index(value)];
+        ++total;
+        max = value > max ? value : max;
+    }
+
+    std::uint64_t count() const
+    {
+        return total;
+    }
+
+    std::uint64_t maxValue() const
+    {
+        return max;
+    }
+
+    std::uint64_t percentile(const double percent) const
+    {
+        const std::uint64_t rank = static_cast<std::uint64_t>(percent / 100.0 * total + 0.5);
+        std::uint64_t seen = 0;
+        for (std::uint32_t i = 0; i < BUCKETS; ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank && seen)
+            {
+                const std::uint64_t value = highestValue(i);
+                return value < max ? value : max;
+            }
+        }
+        return max;
+    }
+};
+
+static void setThreadAffinity(const std::uint32_t cpuId, const int niceness)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpuId, &set);
+    if (0 != sched_setaffinity(0, sizeof(cpu_set_t), &set))
+    {
+       std::cout << "failed to set affinity: " << strerror(errno) << ", cpuId: " << cpuId << "\n";
+       std::abort();
+    }
+
+    if (-1 == nice(niceness))
+    {
+        std::cout << "nice() failed: " << strerror(errno) << ", cpuId: " << cpuId << "\n";
+        std::abort();
+    }
+}
+
+static double tscPerNanosecond()
+{
+    const auto begin = std::chrono::steady_clock::now();
+    const std::uint64_t tscBegin = __rdtsc();
+    std::this_thread::sleep_for(200ms);
+    const std::uint64_t tscEnd = __rdtsc();
+    const auto end = std::chrono::steady_clock::now();
+    return static_cast<double>(tscEnd - tscBegin) / std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+}
+
+volatile bool stopProducer = false;
+static void producerThread(const std::uint32_t cpuId, std::latch& startSync, Buffer* buffer, const std::uint64_t interval)
+{
+    setThreadAffinity(cpuId, -20);
+    brb::PauseBackoff<MAX_BACKOFF> backoff;
+    startSync.arrive_and_wait();
+    std::uint64_t next = __rdtsc();
+    while (!stopProducer)
+    {
+        if (interval)
+        {
+            while (__rdtsc() < next)
+            {
+                asm volatile("pause");
+            }
+        }
+
+        void* data = buffer->reserve(MAX_DATA_SIZE);
+        if (data)
+        {
+            const std::uint64_t timestamp = __rdtsc();
+            memcpy(data, &timestamp, sizeof(timestamp));
+            buffer->commit(data);
+            next += interval;
+            backoff = {};
+        }
+        else
+        {
+            backoff.wait(nullptr);
+        }
+    }
+}
+
+volatile bool stopConsumer = false;
+static void consumerThread(const std::uint32_t cpuId, std::latch& startSync, Buffer* buffer, Histogram& histogram)
+{
+    setThreadAffinity(cpuId, -20);
+    std::uint64_t id = 0;
+
+    startSync.arrive_and_wait();
+    std::uint32_t size;
+    while (!stopConsumer)
+    {
+        void* data = buffer->peek(size, id);
+        if (data)
+        {
+            const std::uint64_t now = __rdtsc();
+            std::uint64_t timestamp;
+            memcpy(&timestamp, data, sizeof(timestamp));
+            buffer->decommit(data, id);
+            histogram.record(now > timestamp ? now - timestamp : 0);
+        }
+        else
+        {
+            asm volatile("pause");
+        }
+    }
+}
+
+Histogram testLatency(const std::uint32_t producersCount, const std::uint64_t interval)
+{
+    Buffer* buffer = new Buffer();
+    Histogram histogram;
+    stopProducer = false;
+    stopConsumer = false;
+    std::latch startSync{ producersCount + 2 };
+
+    std::vector<std::thread> threads;
+    std::uint32_t cpuId = 0;
+    threads.emplace_back(consumerThread, cpuId++, std::ref(startSync), buffer, std::ref(histogram));
+    for (std::uint32_t i = 0; i < producersCount; ++i)
+    {
+        threads.emplace_back(producerThread, cpuId++, std::ref(startSync), buffer, interval);
+    }
+
+    startSync.arrive_and_wait();
+    std::this_thread::sleep_for(1s);
+
+    stopProducer = true;
+    for (std::uint32_t i = 1; i <= producersCount; ++i)
+    {
+        threads[i].join();
+    }
+    stopConsumer = true;
+    threads[0].join();
+
+    delete buffer;
+    return histogram;
+}
+
+int main()
+{
+    const double tscPerNs = tscPerNanosecond();
+    std::cout << "tsc: " << tscPerNs << " ticks per ns, " << CAPACITY << " buckets, latency in ns\n";
+
+    for (std::uint32_t i = 1; i < std::thread::hardware_concurrency(); ++i)
+    {
+        for (const std::uint64_t rate : RATES)
+        {
+            const std::uint64_t interval = rate ? static_cast<std::uint64_t>(tscPerNs * 1e9 / rate) : 0;
+            const Histogram histogram = testLatency(i, interval);
+            std::cout << i << " producers, ";
+            if (rate)
+            {
+                std::cout << rate << " per second each";
+            }
+            else
+            {
+                std::cout << "unlimited rate";
+            }
+            std::cout << ": p50 " << static_cast<std::uint64_t>(histogram.percentile(50.0) / tscPerNs)
+                << ", p99 " << static_cast<std::uint64_t>(histogram.percentile(99.0) / tscPerNs)
+                << ", p99.9 " << static_cast<std::uint64_t>(histogram.percentile(99.9) / tscPerNs)
+                << ", max " << static_cast<std::uint64_t>(histogram.maxValue() / tscPerNs)
+                << ", " << histogram.count() << " messages\n";
+        }
+    }
+
+    return 0;
+}
@@ -28,6 +28,7 @@
  */
 
 #include "BRingBuffer.hpp"
+#include "BShardedRingBuffer.hpp"
 #include <iostream>
 #include <latch>
 #include <thread>
@@ -42,7 +43,40 @@ using namespace std::chrono_literals;
 
 constexpr std::uint32_t MAX_DATA_SIZE = sizeof(std::uint32_t);
 constexpr std::uint32_t CAPACITY = 300;
+constexpr std::uint32_t POW2_CAPACITY = 256;
 constexpr std::uint32_t MAX_BACKOFF = 32;
+constexpr std::uint32_t BATCH_SIZE = 16;
+constexpr std::uint32_t MAX_LANES = 64;
+constexpr std::uint32_t PREFETCH_DISTANCE = 4;
+
+struct PackedTraits : BRingBufferTraits
+{
+    static constexpr brb::Layout layout = brb::Layout::Packed;
+};
+
+struct SplitTraits : BRingBufferTraits
+{
+    static constexpr brb::Layout layout = brb::Layout::Split;
+};
+
+struct SequenceTraits : BRingBufferTraits
+{
+    static constexpr brb::Engine engine = brb::Engine::Sequence;
+};
+
+struct PrefetchTraits : BRingBufferTraits
+{
+    static constexpr std::uint32_t prefetchDistance = PREFETCH_DISTANCE;
+};
+
+using PaddedBuffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE>;
+using PackedBuffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE, PackedTraits>;
+using SplitBuffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE, SplitTraits>;
+using Pow2Buffer = BRingBuffer<POW2_CAPACITY, MAX_DATA_SIZE>;
+// the sequence engine divides by any other capacity, so it is measured with a power of two next to Pow2Buffer
+using SequenceBuffer = BRingBuffer<POW2_CAPACITY, MAX_DATA_SIZE, SequenceTraits>;
+using PrefetchBuffer = BRingBuffer<CAPACITY, MAX_DATA_SIZE, PrefetchTraits>;
+using ShardedBuffer = BShardedRingBuffer<MAX_LANES, CAPACITY, MAX_DATA_SIZE>;
 
 static void setThreadAffinity(const std::uint32_t cpuId, const int niceness)
 {
@@ -63,11 +97,12 @@ static void setThreadAffinity(const std::uint32_t cpuId, const int niceness)
 }
 
 volatile bool stopProducer = false;
-static void producerThread(const std::uint32_t cpuId, std::latch& startSync, BRingBuffer<CAPACITY, MAX_DATA_SIZE>* buffer)
+template<typename Buffer>
+static void producerThread(const std::uint32_t cpuId, std::latch& startSync, Buffer* buffer)
 {
     setThreadAffinity(cpuId, -20);
     auto tid = gettid();
-    std::uint32_t backoffCount = 1;
+    brb::PauseBackoff<MAX_BACKOFF> backoff;
     startSync.arrive_and_wait();
     while (!stopProducer)
     {
@@ -76,22 +111,46 @@ static void producerThread(const std::uint32_t cpuId, std::latch& startSync, BRi
         {
             *static_cast<std::uint32_t*>(data) = tid;
             buffer->commit(data);
-            backoffCount = 1;
+            backoff = {};
         }
         else
         {
-            while (backoffCount--)
+            backoff.wait(nullptr);
+        }
+    }
+}
+
+template<typename Buffer>
+static void producerBatchThread(const std::uint32_t cpuId, std::latch& startSync, Buffer* buffer)
+{
+    setThreadAffinity(cpuId, -20);
+    auto tid = gettid();
+    brb::PauseBackoff<MAX_BACKOFF> backoff;
+    void* data[BATCH_SIZE];
+    startSync.arrive_and_wait();
+    while (!stopProducer)
+    {
+        std::uint32_t count = buffer->reserveBatch(data, BATCH_SIZE, MAX_DATA_SIZE);
+        if (count)
+        {
+            for (std::uint32_t i = 0; i < count; ++i)
             {
-                asm volatile("pause");
+                *static_cast<std::uint32_t*>(data[i]) = tid;
             }
-            backoffCount = backoffCount < MAX_BACKOFF ? backoffCount << 1 : MAX_BACKOFF;
+            buffer->commitBatch(data, count);
+            backoff = {};
+        }
+        else
+        {
+            backoff.wait(nullptr);
         }
     }
 }
 
 std::uint64_t consumedCounter = 0;
 volatile bool stopConsumer = false;
-static void consumerThread(const std::uint32_t cpuId, std::latch& startSync, BRingBuffer<CAPACITY, MAX_DATA_SIZE>* buffer)
+template<typename Buffer>
+static void consumerThread(const std::uint32_t cpuId, std::latch& startSync, Buffer* buffer)
 {
     setThreadAffinity(cpuId, -20);
     std::uint64_t id = 0;
@@ -119,19 +178,54 @@ static void consumerThread(const std::uint32_t cpuId, std::latch& startSync, BRi
     }
 }
 
-std::uint64_t testThroughput(const std::uint32_t producersCount)
+static void shardedConsumerThread(const std::uint32_t cpuId, std::latch& startSync, ShardedBuffer* buffer)
 {
-    BRingBuffer<CAPACITY, MAX_DATA_SIZE>* buffer = new BRingBuffer<CAPACITY, MAX_DATA_SIZE>();
+    setThreadAffinity(cpuId, -20);
+    std::uint32_t backoffCount = MAX_BACKOFF;
+
+    startSync.arrive_and_wait();
+    std::uint32_t size;
+    while (!stopConsumer)
+    {
+        size = 0;
+        void* data = buffer->peek(size);
+        if (data)
+        {
+            buffer->decommit(data);
+            ++consumedCounter;
+        }
+        else
+        {
+            while (backoffCount--)
+            {
+                asm volatile("pause");
+            }
+            backoffCount = MAX_BACKOFF;
+        }
+    }
+}
+
+template<typename Buffer>
+std::uint64_t testThroughput(const std::uint32_t producersCount, const bool batched)
+{
+    Buffer* buffer = new Buffer();
     stopProducer = false;
     stopConsumer = false;
     std::latch startSync{ producersCount + 2 };
 
     std::vector<std::thread> threads;
     std::uint32_t cpuId = 0;
-    threads.emplace_back(consumerThread, cpuId++, std::ref(startSync), buffer);
+    if constexpr (std::is_same_v<Buffer, ShardedBuffer>)
+    {
+        threads.emplace_back(shardedConsumerThread, cpuId++, std::ref(startSync), buffer);
+    }
+    else
+    {
+        threads.emplace_back(consumerThread<Buffer>, cpuId++, std::ref(startSync), buffer);
+    }
     for (std::uint32_t i = 0; i < producersCount; ++i)
     {
-        threads.emplace_back(producerThread, cpuId++, std::ref(startSync), buffer);
+        threads.emplace_back(batched ? producerBatchThread<Buffer> : producerThread<Buffer>, cpuId++, std::ref(startSync), buffer);
     }
 
     startSync.arrive_and_wait();
@@ -153,12 +247,30 @@ std::uint64_t testThroughput(const std::uint32_t producersCount)
 
 int main()
 {
-    std::cout << "buffer size: " << sizeof(BRingBuffer<CAPACITY, MAX_DATA_SIZE>) << " bytes, " << CAPACITY << " buckets\n";
+    std::cout << "buffer size: padded " << sizeof(PaddedBuffer) << " bytes, packed " << sizeof(PackedBuffer) << " bytes, split " << sizeof(SplitBuffer) << " bytes, " << CAPACITY << " buckets, pow2 and sequence " << POW2_CAPACITY << " buckets\n";
+
+    for (std::uint32_t i = 1; i < std::thread::hardware_concurrency(); ++i)
+    {
+        auto padded = testThroughput<PaddedBuffer>(i, false);
+        auto packed = testThroughput<PackedBuffer>(i, false);
+        auto split = testThroughput<SplitBuffer>(i, false);
+        auto pow2 = testThroughput<Pow2Buffer>(i, false);
+        auto sequence = testThroughput<SequenceBuffer>(i, false);
+        auto prefetch = testThroughput<PrefetchBuffer>(i, false);
+        auto sharded = testThroughput<ShardedBuffer>(i, false);
+        std::cout << i << " producers: padded " << padded << ", packed " << packed << ", split " << split << ", pow2 " << pow2 << ", sequence " << sequence << ", prefetch " << prefetch << ", sharded " << sharded << " per second\n";
+    }
 
     for (std::uint32_t i = 1; i < std::thread::hardware_concurrency(); ++i)
     {
-        auto count = testThroughput(i);
-        std::cout << i << " producers: " << count << " per second\n";
+        auto padded = testThroughput<PaddedBuffer>(i, true);
+        auto packed = testThroughput<PackedBuffer>(i, true);
+        auto split = testThroughput<SplitBuffer>(i, true);
+        auto pow2 = testThroughput<Pow2Buffer>(i, true);
+        auto sequence = testThroughput<SequenceBuffer>(i, true);
+        auto prefetch = testThroughput<PrefetchBuffer>(i, true);
+        auto sharded = testThroughput<ShardedBuffer>(i, true);
+        std::cout << i << " producers, batch " << BATCH_SIZE << ": padded " << padded << ", packed " << packed << ", split " << split << ", pow2 " << pow2 << ", sequence " << sequence << ", prefetch " << prefetch << ", sharded " << sharded << " per second\n";
     }
 
     return 0;
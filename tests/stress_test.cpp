@@ -0,0 +1,406 @@
+/*
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "BRingBuffer.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <latch>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+constexpr std::uint32_t MAX_DATA_SIZE = 256;
+constexpr std::uint32_t CAPACITY = 1024;
+constexpr std::uint32_t MAX_BACKOFF = 32;
+constexpr std::uint32_t MIN_DATA_SIZE = 2;
+BRingBuffer<CAPACITY, MAX_DATA_SIZE> buffer;
+
+struct Options
+{
+    std::chrono::seconds duration{ 60 };
+    std::chrono::milliseconds interval{ 1000 };
+    std::uint32_t producers = 0;
+    std::vector<std::uint32_t> cpus;
+    std::uint32_t minSize = MIN_DATA_SIZE;
+    std::uint32_t maxSize = MAX_DATA_SIZE;
+    std::uint64_t rate = 0;
+    std::uint32_t burst = 1;
+    std::chrono::nanoseconds consumerDelay{ 0 };
+};
+
+struct alignas(std::hardware_destructive_interference_size) ProducerCounters
+{
+    std::atomic<std::uint64_t> produced{ 0 };
+    std::atomic<std::uint64_t> attempts{ 0 };
+    std::atomic<std::uint64_t> full{ 0 };
+    std::atomic<std::uint64_t> consumed{ 0 };
+};
+
+thread_local std::uint64_t seed;
+static std::uint64_t splitMix64()
+{
+    std::uint64_t z = (seed += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    z = z ^ (z >> 31);
+    seed = z;
+    return z;
+}
+
+// the first byte holds the producer index, the last one the checksum of the preceding bytes
+static void generateData(char* const bufferPtr, const std::uint32_t dataSize, const std::uint8_t producer)
+{
+    bufferPtr[0] = producer;
+    char checkSum = producer;
+    for (std::uint32_t i = 1; i < dataSize - 1; ++i)
+    {
+        bufferPtr[i] = splitMix64() & 0xFF;
+        checkSum ^= bufferPtr[i];
+    }
+    bufferPtr[dataSize - 1] = checkSum;
+}
+
+static bool verify(const char* const bufferPtr, const std::uint32_t dataSize)
+{
+    char checkSum = 0;
+    for (std::uint32_t i = 0; i < dataSize - 1; ++i)
+    {
+        checkSum ^= bufferPtr[i];
+    }
+
+    return checkSum == bufferPtr[dataSize - 1];
+}
+
+static void setThreadAffinity(const std::uint32_t cpuId)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpuId, &set);
+    if (0 != sched_setaffinity(0, sizeof(cpu_set_t), &set))
+    {
+       std::cerr << "failed to set affinity: " << strerror(errno) << ", cpuId: " << cpuId << "\n";
+       std::abort();
+    }
+}
+
+static void producerThread(const Options& options, const std::uint32_t index, std::latch& startSync, ProducerCounters& counters, const volatile bool& stop)
+{
+    seed = gettid();
+    setThreadAffinity(options.cpus[(index + 1) % options.cpus.size()]);
+    const std::uint32_t sizes = options.maxSize - options.minSize + 1;
+    // with a rate limit the messages are sent in bursts of options.burst, one burst every period
+    const std::chrono::nanoseconds period = options.rate ? std::chrono::nanoseconds(1000000000ull * options.burst / options.rate) : std::chrono::nanoseconds(0);
+    brb::PauseBackoff<MAX_BACKOFF> backoff;
+    std::uint64_t produced = 0;
+    std::uint64_t attempts = 0;
+    std::uint64_t full = 0;
+
+    startSync.arrive_and_wait();
+
+    auto next = std::chrono::steady_clock::now();
+    while (!stop)
+    {
+        for (std::uint32_t i = 0; i < options.burst && !stop;)
+        {
+            const std::uint32_t dataSize = options.minSize + splitMix64() % sizes;
+            void* data = buffer.reserve(dataSize);
+            ++attempts;
+            if (data)
+            {
+                generateData(static_cast<char*>(data), dataSize, index);
+                buffer.commit(data);
+                backoff = {};
+                ++produced;
+                ++i;
+            }
+            else
+            {
+                ++full;
+                backoff.wait(nullptr);
+            }
+        }
+        counters.produced.store(produced, std::memory_order_relaxed);
+        counters.attempts.store(attempts, std::memory_order_relaxed);
+        counters.full.store(full, std::memory_order_relaxed);
+
+        if (options.rate)
+        {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
+
+static void consumerThread(const Options& options, std::latch& startSync, std::vector<ProducerCounters>& counters, const volatile bool& stop)
+{
+    setThreadAffinity(options.cpus[0]);
+    std::vector<std::uint64_t> consumed(counters.size(), 0);
+    std::uint64_t id = 0;
+    startSync.arrive_and_wait();
+
+    while (!stop)
+    {
+        std::uint32_t size = 0;
+        void* data = buffer.peek(size, id);
+        if (data)
+        {
+            const std::uint8_t producer = *static_cast<const char*>(data);
+            if (size < options.minSize || size > options.maxSize || producer >= counters.size() || false == verify(static_cast<char*>(data), size))
+            {
+                std::cout << "data corrupted!\n";
+                std::abort();
+            }
+            if (options.consumerDelay.count())
+            {
+                const auto until = std::chrono::steady_clock::now() + options.consumerDelay;
+                while (std::chrono::steady_clock::now() < until)
+                {
+                    asm volatile("pause");
+                }
+            }
+            buffer.decommit(data, id);
+            counters[producer].consumed.store(++consumed[producer], std::memory_order_relaxed);
+        }
+        else
+        {
+            asm volatile("pause");
+        }
+    }
+}
+
+struct Sample
+{
+    std::uint64_t consumed = 0;
+    std::uint64_t attempts = 0;
+    std::uint64_t full = 0;
+    std::vector<std::uint64_t> perProducer;
+};
+
+static Sample takeSample(const std::vector<ProducerCounters>& counters)
+{
+    Sample sample;
+    for (const ProducerCounters& producer : counters)
+    {
+        const std::uint64_t consumed = producer.consumed.load(std::memory_order_relaxed);
+        sample.consumed += consumed;
+        sample.attempts += producer.attempts.load(std::memory_order_relaxed);
+        sample.full += producer.full.load(std::memory_order_relaxed);
+        sample.perProducer.push_back(consumed);
+    }
+    return sample;
+}
+
+// Jain's fairness index of the messages consumed from every producer, 1 when all got the same share
+static double fairness(const Sample& from, const Sample& to)
+{
+    double sum = 0;
+    double squares = 0;
+    for (std::size_t i = 0; i < to.perProducer.size(); ++i)
+    {
+        const double count = to.perProducer[i] - from.perProducer[i];
+        sum += count;
+        squares += count * count;
+    }
+    return squares > 0 ? sum * sum / (to.perProducer.size() * squares) : 1.0;
+}
+
+static void report(const char* label, const Sample& from, const Sample& to, const double seconds)
+{
+    const std::uint64_t attempts = to.attempts - from.attempts;
+    std::printf("%s,%.0f,%.3f,%.6f\n", label, (to.consumed - from.consumed) / seconds,
+        attempts ? 100.0 * (to.full - from.full) / attempts : 0.0, fairness(from, to));
+    std::fflush(stdout);
+}
+
+static std::vector<std::uint32_t> parseList(const char* arg)
+{
+    std::vector<std::uint32_t> list;
+    for (const char* ptr = arg; *ptr;)
+    {
+        char* end;
+        list.push_back(std::strtoul(ptr, &end, 10));
+        ptr = *end ? end + 1 : end;
+    }
+    return list;
+}
+
+static void usage(const char* name)
+{
+    std::cerr << "usage: " << name << " [--duration S] [--interval MS] [--producers N] [--cpus 0,2,4] [--min-size N] [--max-size N] [--rate MSGS_PER_S] [--burst N] [--consumer-delay NS]\n";
+    std::exit(1);
+}
+
+static Options parseOptions(const int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i + 1 == argc)
+        {
+            usage(argv[0]);
+        }
+        else if ("--duration" == arg)
+        {
+            options.duration = std::chrono::seconds(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if ("--interval" == arg)
+        {
+            options.interval = std::chrono::milliseconds(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if ("--producers" == arg)
+        {
+            options.producers = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if ("--cpus" == arg)
+        {
+            options.cpus = parseList(argv[++i]);
+        }
+        else if ("--min-size" == arg)
+        {
+            options.minSize = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if ("--max-size" == arg)
+        {
+            options.maxSize = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if ("--rate" == arg)
+        {
+            options.rate = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if ("--burst" == arg)
+        {
+            options.burst = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if ("--consumer-delay" == arg)
+        {
+            options.consumerDelay = std::chrono::nanoseconds(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            usage(argv[0]);
+        }
+    }
+
+    if (options.cpus.empty())
+    {
+        for (std::uint32_t i = 0; i < std::thread::hardware_concurrency(); ++i)
+        {
+            options.cpus.push_back(i);
+        }
+    }
+    if (0 == options.producers)
+    {
+        options.producers = std::max<std::uint32_t>(options.cpus.size() - 1, 1);
+    }
+    if (0 == options.duration.count() || 0 == options.interval.count() || 0 == options.burst || options.producers > 0xFF ||
+        options.minSize < MIN_DATA_SIZE || options.minSize > options.maxSize || options.maxSize > MAX_DATA_SIZE)
+    {
+        usage(argv[0]);
+    }
+    return options;
+}
+
+int main(int argc, char** argv)
+{
+    const Options options = parseOptions(argc, argv);
+    std::cout << "buffer size : " << sizeof(buffer) << " bytes, producers : " << options.producers << ", payload : "
+              << options.minSize << "-" << options.maxSize << " bytes\n";
+
+    std::vector<ProducerCounters> counters(options.producers);
+    volatile bool stopProducer = false;
+    volatile bool stopConsumer = false;
+    std::latch startSync{ options.producers + 2 };
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(consumerThread, std::cref(options), std::ref(startSync), std::ref(counters), std::cref(stopConsumer));
+    for (std::uint32_t i = 0; i < options.producers; ++i)
+    {
+        threads.emplace_back(producerThread, std::cref(options), i, std::ref(startSync), std::ref(counters[i]), std::cref(stopProducer));
+    }
+
+    startSync.arrive_and_wait();
+
+    std::cout << "time_s,msgs_per_s,full_pct,fairness\n";
+    const auto start = std::chrono::steady_clock::now();
+    const Sample first = takeSample(counters);
+    Sample last = first;
+    auto lastTime = start;
+    for (auto next = start + options.interval; next <= start + options.duration; next += options.interval)
+    {
+        std::this_thread::sleep_until(next);
+        const auto now = std::chrono::steady_clock::now();
+        const Sample sample = takeSample(counters);
+        const std::string label = std::to_string(std::chrono::duration<double>(now - start).count());
+        report(label.c_str(), last, sample, std::chrono::duration<double>(now - lastTime).count());
+        last = sample;
+        lastTime = now;
+    }
+    report("total", first, last, std::chrono::duration<double>(lastTime - start).count());
+
+    stopProducer = true;
+    for (std::uint32_t i = 1; i <= options.producers; ++i)
+    {
+        threads[i].join();
+    }
+
+    std::uint64_t produced = 0;
+    for (const ProducerCounters& producer : counters)
+    {
+        produced += producer.produced.load();
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (takeSample(counters).consumed != produced && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stopConsumer = true;
+    threads[0].join();
+
+    const Sample final = takeSample(counters);
+    if (final.consumed != produced)
+    {
+        std::cout << "test failed!\n";
+    }
+    std::cout << "consumed : " << final.consumed << ", produced : " << produced << "\n";
+    for (std::uint32_t i = 0; i < options.producers; ++i)
+    {
+        std::cout << "producer " << i << " : " << final.perProducer[i] << "\n";
+    }
+
+    return final.consumed == produced ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2025 Jakub Krawczyk jaksa.krawczyk at gmail com
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met :
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and /or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __TOPOLOGY_HPP
+#define __TOPOLOGY_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// cpus are identified by the first cpu of the sysfs lists sharing the same core or L3 cache
+struct Cpu
+{
+    std::uint32_t id;
+    std::uint32_t core;
+    std::uint32_t l3;
+    std::uint32_t package;
+};
+
+inline const char* const PLACEMENTS[] = { "smt", "l3", "cross-l3", "cross-socket" };
+
+inline std::vector<std::uint32_t> parseCpuList(const std::string& list)
+{
+    std::vector<std::uint32_t> cpus;
+    for (std::size_t position = 0; position < list.size();)
+    {
+        std::size_t end;
+        const std::uint32_t first = std::stoul(list.substr(position), &end);
+        std::uint32_t last = first;
+        position += end;
+        if (position < list.size() && '-' == list[position])
+        {
+            last = std::stoul(list.substr(position + 1), &end);
+            position += end + 1;
+        }
+        for (std::uint32_t cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+        position = list.find(',', position);
+        position = std::string::npos == position ? list.size() : position + 1;
+    }
+    return cpus;
+}
+
+inline std::string readSysfs(const std::string& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+inline std::vector<Cpu> readTopology()
+{
+    std::vector<Cpu> topology;
+    const std::string online = readSysfs("/sys/devices/system/cpu/online");
+    for (const std::uint32_t id : parseCpuList(online.empty() ? "0" : online))
+    {
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/";
+        const std::string siblings = readSysfs(base + "topology/thread_siblings_list");
+        const std::string l3 = readSysfs(base + "cache/index3/shared_cpu_list");
+        const std::string package = readSysfs(base + "topology/physical_package_id");
+
+        const std::uint32_t packageId = package.empty() ? 0 : std::stoul(package);
+        const std::uint32_t coreId = siblings.empty() ? id : parseCpuList(siblings)[0];
+        // without an L3 cache every package is a single L3 domain
+        const std::uint32_t l3Id = l3.empty() ? 0x80000000 | packageId : parseCpuList(l3)[0];
+        topology.push_back({ id, coreId, l3Id, packageId });
+    }
+    return topology;
+}
+
+inline bool placementMatches(const std::string& placement, const Cpu& consumer, const Cpu& producer)
+{
+    if ("smt" == placement)
+    {
+        return producer.core == consumer.core;
+    }
+    if ("l3" == placement)
+    {
+        return producer.core != consumer.core && producer.l3 == consumer.l3;
+    }
+    if ("cross-l3" == placement)
+    {
+        return producer.l3 != consumer.l3 && producer.package == consumer.package;
+    }
+    return producer.package != consumer.package;
+}
+
+// the consumer cpu comes first, followed by producersCount cpus in the given placement relative to it, empty if the machine has no such cpus
+inline std::vector<std::uint32_t> placeThreads(const std::vector<Cpu>& topology, const std::string& placement, const std::uint32_t producersCount)
+{
+    for (const Cpu& consumer : topology)
+    {
+        std::vector<std::uint32_t> cpus{ consumer.id };
+        for (const Cpu& producer : topology)
+        {
+            if (cpus.size() <= producersCount && producer.id != consumer.id && placementMatches(placement, consumer, producer))
+            {
+                cpus.push_back(producer.id);
+            }
+        }
+
+        if (cpus.size() == producersCount + 1)
+        {
+            return cpus;
+        }
+    }
+    return {};
+}
+
+#endif